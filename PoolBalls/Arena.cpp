@@ -0,0 +1,142 @@
+﻿/*
+ * @descrição	Ficheiro com todo o código relativo ao alocador linear usado ao ler os recursos.
+ * @ficheiro	Arena.cpp
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+ *
+ * -------------------------------------
+ *
+ * Ao interpretar um .obj, os vetores crescem aos poucos e cada linha cria objetos temporários, o que dá
+ * centenas de milhares de alocações no heap durante o arranque. Com a arena, quem lê o ficheiro conta
+ * primeiro os elementos, reserva de uma só vez um bloco com o tamanho total (reserve) e depois só avança
+ * um ponteiro dentro dele. Quando os dados já foram enviados para a GPU, a arena é libertada inteira.
+*/
+
+
+#pragma region importações
+
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+
+#include "Arena.h"
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region funções auxiliares do alocador linear
+
+	// primeira posição a partir de offset cujo endereço é múltiplo de alignment (potência de 2)
+	static size_t alignOffset(const ArenaBlock* block, size_t offset, size_t alignment) {
+		uintptr_t address = (uintptr_t)(block + 1) + offset;
+		return offset + ((alignment - (address & (alignment - 1))) & (alignment - 1));
+	}
+
+#pragma endregion
+
+
+#pragma region funções getters da classe Arena
+
+	size_t Arena::getUsedBytes() const {
+		return _usedBytes;
+	}
+
+	size_t Arena::getReservedBytes() const {
+		return _reservedBytes;
+	}
+
+	int Arena::getNumberOfBlocks() const {
+		return _numberOfBlocks;
+	}
+
+#pragma endregion
+
+
+#pragma region construtores e destrutor da classe Arena
+
+	Arena::Arena() : Arena(ARENA_BLOCK_SIZE) {
+	}
+
+	Arena::Arena(size_t blockSize) {
+		_block = nullptr;
+		_blockSize = blockSize;
+		_usedBytes = 0;
+		_reservedBytes = 0;
+		_numberOfBlocks = 0;
+	}
+
+	Arena::~Arena() {
+		reset();
+	}
+
+#pragma endregion
+
+
+#pragma region funções principais da classe Arena
+
+	void Arena::reserve(size_t size) {
+		// se o bloco atual já tem espaço livre suficiente
+		if (_block && _block->size - _block->offset >= size) {
+			return;
+		}
+
+		addBlock(size);
+	}
+
+	void* Arena::allocate(size_t size, size_t alignment) {
+		// posição alinhada dentro do bloco atual (o alinhamento é o do endereço, não o da posição no bloco)
+		size_t offset = _block ? alignOffset(_block, _block->offset, alignment) : 0;
+
+		// se não cabe no bloco atual, pede outro (com folga para o alinhamento)
+		if (!_block || offset + size > _block->size) {
+			addBlock(size + alignment);
+			offset = alignOffset(_block, 0, alignment);
+		}
+
+		unsigned char* data = (unsigned char*)(_block + 1) + offset;
+		_usedBytes += offset + size - _block->offset;
+		_block->offset = offset + size;
+
+		return data;
+	}
+
+	void Arena::reset(void) {
+		// liberta todos os blocos de uma só vez
+		while (_block) {
+			ArenaBlock* next = _block->next;
+			std::free(_block);
+			_block = next;
+		}
+
+		_usedBytes = 0;
+		_reservedBytes = 0;
+		_numberOfBlocks = 0;
+	}
+
+#pragma endregion
+
+
+#pragma region funções secundárias da classe Arena
+
+	void Arena::addBlock(size_t size) {
+		size = size > _blockSize ? size : _blockSize;
+
+		ArenaBlock* block = (ArenaBlock*)std::malloc(sizeof(ArenaBlock) + size);
+
+		if (!block) {
+			throw std::bad_alloc();
+		}
+
+		block->next = _block;
+		block->size = size;
+		block->offset = 0;
+		_block = block;
+		_reservedBytes += size;
+		_numberOfBlocks++;
+	}
+
+#pragma endregion
+
+}
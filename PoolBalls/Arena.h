@@ -0,0 +1,86 @@
+/*
+ * @descrição	Ficheiro com todas as assinaturas relativas ao alocador linear usado ao ler os recursos.
+ * @ficheiro	Arena.h
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+*/
+
+
+#pragma once
+
+#ifndef ARENA_H
+#define ARENA_H 1
+
+#pragma region importações
+
+#include <cstddef>
+
+#pragma endregion
+
+
+#pragma region constantes
+
+#define ARENA_BLOCK_SIZE (1024 * 1024)	// tamanho mínimo de cada bloco pedido ao sistema
+#define ARENA_ALIGNMENT 16				// alinhamento por omissão de cada alocação
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region declarações do alocador linear
+
+	// estrutura do cabeçalho de cada bloco da arena (seguido dos dados)
+	typedef struct ArenaBlock {
+		struct ArenaBlock* next;	// bloco anterior (os blocos formam uma lista, do mais recente para o mais antigo)
+		size_t size;				// bytes de dados do bloco
+		size_t offset;				// primeiro byte livre do bloco
+	} ArenaBlock;
+
+	// classe de um alocador linear: cada alocação só avança uma posição dentro do bloco atual e
+	// toda a memória é libertada de uma só vez (não há libertações individuais)
+	class Arena {
+	private:
+		// atributos privados
+		ArenaBlock* _block;		// bloco atual
+		size_t _blockSize;
+		size_t _usedBytes;
+		size_t _reservedBytes;
+		int _numberOfBlocks;
+
+		// secundárias
+		void addBlock(size_t size);
+
+	public:
+		// getters - obter valores de atributos fora da classe
+		size_t getUsedBytes() const;
+		size_t getReservedBytes() const;
+		int getNumberOfBlocks() const;
+
+		// construtores
+		Arena();
+		Arena(size_t blockSize);
+		Arena(const Arena&) = delete;
+
+		// destrutor
+		~Arena();
+
+		// operadores
+		Arena& operator=(const Arena&) = delete;
+
+		// principais
+		void reserve(size_t size);
+		void* allocate(size_t size, size_t alignment);
+		void reset(void);
+
+		template <typename T>
+		T* allocateArray(size_t count) {
+			return (T*)allocate(count * sizeof(T), alignof(T) > ARENA_ALIGNMENT ? alignof(T) : ARENA_ALIGNMENT);
+		}
+	};
+
+#pragma endregion
+
+}
+
+#endif
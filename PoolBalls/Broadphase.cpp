@@ -0,0 +1,150 @@
+﻿/*
+ * @descrição	Ficheiro com todo o código relativo à deteção de pares candidatos a colisão.
+ * @ficheiro	Broadphase.cpp
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+ *
+ * -------------------------------------
+ *
+ * Cada bola é guardada na célula da grelha que contém o seu centro. Como o lado da célula é igual ao
+ * diâmetro de uma bola, duas bolas que se tocam estão sempre na mesma célula ou em células vizinhas,
+ * pelo que basta percorrer as 3x3 células à volta de cada bola em movimento.
+*/
+
+
+#pragma region importações
+
+#include <cmath>
+#include <vector>
+#include <unordered_map>
+
+#include <glm\glm.hpp>
+
+#include "Broadphase.h"
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region funções getters da classe UniformGrid
+
+	float UniformGrid::getCellSize() const {
+		return _cellSize;
+	}
+
+	int UniformGrid::getNumberOfOccupiedCells() const {
+		return (int)_cells.size();
+	}
+
+#pragma endregion
+
+
+#pragma region construtor da classe UniformGrid
+
+	UniformGrid::UniformGrid(float cellSize) {
+		_cellSize = cellSize;
+	}
+
+#pragma endregion
+
+
+#pragma region funções principais da classe UniformGrid
+
+	void UniformGrid::insert(int ball, glm::vec3 position) {
+		// garante espaço para a célula de cada bola
+		if (ball >= (int)_ballCells.size()) {
+			_ballCells.resize(ball + 1);
+		}
+
+		long long key = getCellKey(getCellCoord(position.x), getCellCoord(position.z));
+		_cells[key].push_back(ball);
+		_ballCells[ball] = key;
+	}
+
+	void UniformGrid::move(int ball, glm::vec3 position) {
+		long long key = getCellKey(getCellCoord(position.x), getCellCoord(position.z));
+
+		// só atualiza a grelha quando a bola muda de célula
+		if (key == _ballCells[ball]) {
+			return;
+		}
+
+		removeFromCell(ball, _ballCells[ball]);
+		_cells[key].push_back(ball);
+		_ballCells[ball] = key;
+	}
+
+	void UniformGrid::findPairs(const std::vector<int>& movingBalls, const std::vector<bool>& isMoving, PairList& pairs) const {
+		pairs.ballA.clear();
+		pairs.ballB.clear();
+
+		for (int ball : movingBalls) {
+			// coordenadas da célula da bola
+			long long key = _ballCells[ball];
+			int cellX = (int)(key >> 32);
+			int cellZ = (int)(key & 0xFFFFFFFF);
+
+			// percorre a célula da bola e as suas vizinhas
+			for (int dx = -1; dx <= 1; dx++) {
+				for (int dz = -1; dz <= 1; dz++) {
+					auto cell = _cells.find(getCellKey(cellX + dx, cellZ + dz));
+
+					if (cell == _cells.end()) {
+						continue;
+					}
+
+					for (int other : cell->second) {
+						// quando ambas se movem, o par só é gerado uma vez (pela bola de menor índice)
+						if (other == ball || (isMoving[other] && other < ball)) {
+							continue;
+						}
+
+						pairs.ballA.push_back(ball);
+						pairs.ballB.push_back(other);
+					}
+				}
+			}
+		}
+	}
+
+	void UniformGrid::clear(void) {
+		_cells.clear();
+		_ballCells.clear();
+	}
+
+#pragma endregion
+
+
+#pragma region funções secundárias da classe UniformGrid
+
+	long long UniformGrid::getCellKey(int cellX, int cellZ) const {
+		return ((long long)cellX << 32) | (unsigned int)cellZ;
+	}
+
+	int UniformGrid::getCellCoord(float value) const {
+		return (int)std::floor(value / _cellSize);
+	}
+
+	void UniformGrid::removeFromCell(int ball, long long key) {
+		auto cell = _cells.find(key);
+		std::vector<int>& balls = cell->second;
+
+		// remove trocando com a última bola da célula (a ordem não importa)
+		for (size_t i = 0; i < balls.size(); i++) {
+			if (balls[i] == ball) {
+				balls[i] = balls.back();
+				balls.pop_back();
+				break;
+			}
+		}
+
+		// liberta as células vazias para a tabela não crescer com o movimento das bolas
+		if (balls.empty()) {
+			_cells.erase(cell);
+		}
+	}
+
+#pragma endregion
+
+}
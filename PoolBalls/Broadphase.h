@@ -0,0 +1,66 @@
+/*
+ * @descrição	Ficheiro com todas as assinaturas relativas à deteção de pares candidatos a colisão.
+ * @ficheiro	Broadphase.h
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+*/
+
+
+#pragma once
+
+#ifndef BROADPHASE_H
+#define BROADPHASE_H 1
+
+#pragma region importações
+
+#include <vector>
+#include <unordered_map>
+
+#include <glm\glm.hpp>
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region declarações da broadphase
+
+	// estrutura com os pares de bolas candidatos a colisão (um array por bola do par, para os kernels SIMD)
+	typedef struct {
+		std::vector<int> ballA;		// índices da primeira bola de cada par
+		std::vector<int> ballB;		// índices da segunda bola de cada par
+	} PairList;
+
+	// classe da grelha uniforme (tabela de dispersão espacial) no plano XZ da mesa
+	class UniformGrid {
+	private:
+		// atributos privados
+		float _cellSize;										// lado de cada célula (diâmetro de uma bola)
+		std::unordered_map<long long, std::vector<int>> _cells;	// bolas em cada célula ocupada
+		std::vector<long long> _ballCells;						// célula atual de cada bola
+
+		// secundárias
+		long long getCellKey(int cellX, int cellZ) const;
+		int getCellCoord(float value) const;
+		void removeFromCell(int ball, long long key);
+
+	public:
+		// getters - obter valores de atributos fora da classe
+		float getCellSize() const;
+		int getNumberOfOccupiedCells() const;
+
+		// construtor
+		UniformGrid(float cellSize);
+
+		// principais
+		void insert(int ball, glm::vec3 position);
+		void move(int ball, glm::vec3 position);
+		void findPairs(const std::vector<int>& movingBalls, const std::vector<bool>& isMoving, PairList& pairs) const;
+		void clear(void);
+	};
+
+#pragma endregion
+
+}
+
+#endif
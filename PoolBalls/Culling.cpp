@@ -0,0 +1,228 @@
+﻿/*
+ * @descrição	Ficheiro com todo o código relativo ao descarte dos objetos fora da pirâmide de visão.
+ * @ficheiro	Culling.cpp
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+ *
+ * -------------------------------------
+ *
+ * Cada malha tem uma esfera envolvente, calculada uma única vez ao ser carregada. Em cada frame, a esfera
+ * de cada objeto é levada para o espaço do mundo com a sua matriz de modelo e testada contra os 6 planos
+ * da pirâmide de visão, extraídos da matriz projeção * visualização. Os objetos cuja esfera fica
+ * totalmente do lado de fora de algum plano não são enviados para a GPU.
+ *
+ * As esferas ficam guardadas em arrays separados (x[], y[], z[], raio[]) para o kernel SSE testar
+ * 4 esferas por instrução; as que sobram são testadas pela versão escalar. O SSE existe em todos os
+ * processadores x86/x64 para que o projeto é compilado, por isso não há escolha em tempo de execução.
+*/
+
+
+#pragma region importações
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include <immintrin.h>
+
+#include <glm\glm.hpp>
+
+#include "Culling.h"
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region funções getters e setters da classe FrustumCuller
+
+	// getters
+	int FrustumCuller::getNumberOfObjects() const {
+		return (int)_radius.size();
+	}
+
+	bool FrustumCuller::isVisible(int index) const {
+		return _visible[index] != 0;
+	}
+
+	const CullingStats& FrustumCuller::getStats() const {
+		return _stats;
+	}
+
+	// setters
+	void FrustumCuller::setNumberOfObjects(int numberOfObjects) {
+		_x.resize(numberOfObjects);
+		_y.resize(numberOfObjects);
+		_z.resize(numberOfObjects);
+		_radius.resize(numberOfObjects);
+		_visible.resize(numberOfObjects, 1);
+	}
+
+	void FrustumCuller::setSphere(int index, const BoundingSphere& sphere) {
+		_x[index] = sphere.center.x;
+		_y[index] = sphere.center.y;
+		_z[index] = sphere.center.z;
+		_radius[index] = sphere.radius;
+	}
+
+#pragma endregion
+
+
+#pragma region construtor da classe FrustumCuller
+
+	FrustumCuller::FrustumCuller() {
+		_stats.tested = 0;
+		_stats.culled = 0;
+	}
+
+#pragma endregion
+
+
+#pragma region funções principais da classe FrustumCuller
+
+	int FrustumCuller::Cull(const Frustum& frustum) {
+		int count = (int)_radius.size();
+		int numberOfVisible = cullSpheresSse(frustum, _x.data(), _y.data(), _z.data(), _radius.data(), count, _visible.data());
+
+		_stats.tested = count;
+		_stats.culled = count - numberOfVisible;
+
+		return numberOfVisible;
+	}
+
+#pragma endregion
+
+
+#pragma region kernels do descarte
+
+	int cullSpheresScalar(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius, int count, unsigned char* visible) {
+		int numberOfVisible = 0;
+
+		for (int i = 0; i < count; i++) {
+			bool inside = true;
+
+			// a esfera é descartada se estiver toda do lado de fora de um dos planos
+			for (int p = 0; p < FRUSTUM_PLANES && inside; p++) {
+				float distance = frustum.a[p] * x[i] + frustum.b[p] * y[i] + frustum.c[p] * z[i] + frustum.d[p];
+				inside = distance >= -radius[i];
+			}
+
+			visible[i] = inside ? 1 : 0;
+			numberOfVisible += inside ? 1 : 0;
+		}
+
+		return numberOfVisible;
+	}
+
+	int cullSpheresSse(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius, int count, unsigned char* visible) {
+		int numberOfVisible = 0;
+		int i = 0;
+
+		// 4 esferas de cada vez, contra os 6 planos (sem saltos: todos os planos são testados)
+		for (; i + 4 <= count; i += 4) {
+			__m128 sphereX = _mm_loadu_ps(x + i);
+			__m128 sphereY = _mm_loadu_ps(y + i);
+			__m128 sphereZ = _mm_loadu_ps(z + i);
+			__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+			__m128 inside = _mm_cmpeq_ps(sphereX, sphereX);	// todos os bits a 1 (a não ser que o centro seja NaN)
+
+			for (int p = 0; p < FRUSTUM_PLANES; p++) {
+				__m128 distance = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(frustum.a[p]), sphereX), _mm_mul_ps(_mm_set1_ps(frustum.b[p]), sphereY)),
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(frustum.c[p]), sphereZ), _mm_set1_ps(frustum.d[p])));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+			}
+
+			int mask = _mm_movemask_ps(inside);
+			for (int k = 0; k < 4; k++) {
+				visible[i + k] = (mask >> k) & 1;
+			}
+			numberOfVisible += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+		}
+
+		// esferas que sobram
+		return numberOfVisible + cullSpheresScalar(frustum, x + i, y + i, z + i, radius + i, count - i, visible + i);
+	}
+
+#pragma endregion
+
+
+#pragma region funções globais do descarte
+
+	Frustum extractFrustum(const glm::mat4& viewProjection) {
+		Frustum frustum;
+
+		// cada plano é a soma ou diferença entre a última linha da matriz e uma das outras (as matrizes da glm são por colunas)
+		glm::vec4 row0 = glm::vec4(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+		glm::vec4 row1 = glm::vec4(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+		glm::vec4 row2 = glm::vec4(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+		glm::vec4 row3 = glm::vec4(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+		glm::vec4 planes[FRUSTUM_PLANES] = {
+			row3 + row0,	// esquerdo
+			row3 - row0,	// direito
+			row3 + row1,	// inferior
+			row3 - row1,	// superior
+			row3 + row2,	// próximo
+			row3 - row2		// distante
+		};
+
+		for (int p = 0; p < FRUSTUM_PLANES; p++) {
+			// normalizado, para a distância ao plano ser comparável com o raio da esfera
+			float length = glm::length(glm::vec3(planes[p]));
+			glm::vec4 plane = planes[p] / length;
+
+			frustum.a[p] = plane.x;
+			frustum.b[p] = plane.y;
+			frustum.c[p] = plane.z;
+			frustum.d[p] = plane.w;
+		}
+
+		return frustum;
+	}
+
+	BoundingSphere computeBoundingSphere(const float* vertices, int numberOfVertices, int stride) {
+		BoundingSphere sphere = { glm::vec3(0.0f), 0.0f };
+
+		// se não há vértices
+		if (!vertices || numberOfVertices <= 0) {
+			return sphere;
+		}
+
+		// o centro é o da caixa envolvente (a posição são os 3 primeiros floats de cada vértice)
+		glm::vec3 minimum = glm::vec3(vertices[0], vertices[1], vertices[2]);
+		glm::vec3 maximum = minimum;
+		for (int i = 1; i < numberOfVertices; i++) {
+			const float* position = vertices + (size_t)i * stride;
+			minimum = glm::min(minimum, glm::vec3(position[0], position[1], position[2]));
+			maximum = glm::max(maximum, glm::vec3(position[0], position[1], position[2]));
+		}
+		sphere.center = (minimum + maximum) * 0.5f;
+
+		// o raio é a distância ao vértice mais afastado do centro
+		float radiusSquared = 0.0f;
+		for (int i = 0; i < numberOfVertices; i++) {
+			const float* position = vertices + (size_t)i * stride;
+			glm::vec3 offset = glm::vec3(position[0], position[1], position[2]) - sphere.center;
+			radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+		}
+		sphere.radius = std::sqrt(radiusSquared);
+
+		return sphere;
+	}
+
+	BoundingSphere transformBoundingSphere(const BoundingSphere& sphere, const glm::mat4& model) {
+		BoundingSphere transformed;
+
+		// o raio cresce com a maior escala da matriz de modelo (a esfera continua a envolver o objeto)
+		float scale = std::max({ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) });
+
+		transformed.center = glm::vec3(model * glm::vec4(sphere.center, 1.0f));
+		transformed.radius = sphere.radius * scale;
+
+		return transformed;
+	}
+
+#pragma endregion
+
+}
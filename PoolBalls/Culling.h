@@ -0,0 +1,97 @@
+/*
+ * @descrição	Ficheiro com todas as assinaturas relativas ao descarte dos objetos fora da pirâmide de visão.
+ * @ficheiro	Culling.h
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+*/
+
+
+#pragma once
+
+#ifndef CULLING_H
+#define CULLING_H 1
+
+#pragma region importações
+
+#include <vector>
+
+#include <glm\glm.hpp>
+
+#pragma endregion
+
+
+#pragma region constantes
+
+#define FRUSTUM_PLANES 6	// planos da pirâmide de visão (esquerdo, direito, inferior, superior, próximo e distante)
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region declarações do descarte por pirâmide de visão
+
+	// estrutura de uma esfera envolvente
+	typedef struct {
+		glm::vec3 center;
+		float radius;
+	} BoundingSphere;
+
+	// estrutura dos planos da pirâmide de visão (SoA: cada coeficiente num array, para testar 4 esferas por instrução)
+	// um ponto p está do lado de dentro do plano i se a[i] * p.x + b[i] * p.y + c[i] * p.z + d[i] >= 0
+	typedef struct {
+		float a[FRUSTUM_PLANES];
+		float b[FRUSTUM_PLANES];
+		float c[FRUSTUM_PLANES];
+		float d[FRUSTUM_PLANES];
+	} Frustum;
+
+	// estrutura com as estatísticas do último descarte
+	typedef struct {
+		int tested;		// objetos testados
+		int culled;		// objetos descartados (fora da pirâmide de visão)
+	} CullingStats;
+
+	// classe que guarda as esferas envolventes dos objetos da cena e as testa contra a pirâmide de visão
+	class FrustumCuller {
+	private:
+		// atributos privados
+		std::vector<float> _x;
+		std::vector<float> _y;
+		std::vector<float> _z;
+		std::vector<float> _radius;
+		std::vector<unsigned char> _visible;
+		CullingStats _stats;
+
+	public:
+		// getters - obter valores de atributos fora da classe
+		int getNumberOfObjects() const;
+		bool isVisible(int index) const;
+		const CullingStats& getStats() const;
+
+		// setters - definir valores de atributos fora da classe
+		void setNumberOfObjects(int numberOfObjects);
+		void setSphere(int index, const BoundingSphere& sphere);
+
+		// construtor
+		FrustumCuller();
+
+		// principais
+		int Cull(const Frustum& frustum);
+	};
+
+	// kernels de descarte: recebem as esferas (SoA), escrevem em visible 1 para cada esfera que interseta
+	// a pirâmide de visão (0 caso contrário) e retornam o número de esferas visíveis
+	int cullSpheresScalar(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius, int count, unsigned char* visible);
+	int cullSpheresSse(const Frustum& frustum, const float* x, const float* y, const float* z, const float* radius, int count, unsigned char* visible);
+
+	// funções globais do descarte
+	Frustum extractFrustum(const glm::mat4& viewProjection);
+	BoundingSphere computeBoundingSphere(const float* vertices, int numberOfVertices, int stride);
+	BoundingSphere transformBoundingSphere(const BoundingSphere& sphere, const glm::mat4& model);
+
+#pragma endregion
+
+}
+
+#endif
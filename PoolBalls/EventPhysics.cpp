@@ -0,0 +1,348 @@
+﻿/*
+ * @descrição	Ficheiro com todo o código relativo à simulação física orientada a eventos.
+ * @ficheiro	EventPhysics.cpp
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+ *
+ * -------------------------------------
+ *
+ * Em vez de avançar em passos pequenos e verificar colisões depois de acontecerem, esta simulação calcula
+ * analiticamente o instante da próxima colisão de cada bola (com outra bola ou com uma tabela), guarda-as numa
+ * fila de prioridade e salta diretamente de evento em evento. Entre eventos as bolas andam em linha reta,
+ * por isso a posição de cada bola é calculada apenas quando é necessária.
+ *
+ * Quando uma bola colide, o seu contador de colisões é incrementado; os eventos previstos com o contador
+ * antigo ficam inválidos e são ignorados ao sair da fila, e só as bolas envolvidas voltam a ser previstas.
+ *
+ * Esta simulação não tem atrito: as bolas mantêm a velocidade entre colisões.
+*/
+
+
+#pragma region importações
+
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <queue>
+
+#include <glm\glm.hpp>
+#include <glm\gtc\quaternion.hpp>
+
+#include "Physics.h"
+#include "EventPhysics.h"
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region constantes
+
+	static const double NO_HIT = std::numeric_limits<double>::infinity();
+
+#pragma endregion
+
+
+#pragma region funções getters e setters da classe EventPhysics
+
+	// getters
+	int EventPhysics::getNumberOfBalls() const {
+		return _balls.count;
+	}
+
+	glm::vec3 EventPhysics::getPosition(int ball) const {
+		// posição extrapolada desde o último evento da bola
+		float dt = (float)(_time - _ballTime[ball]);
+
+		return glm::vec3(
+			_balls.x[ball] + _balls.vx[ball] * dt,
+			_balls.y[ball] + _balls.vy[ball] * dt,
+			_balls.z[ball] + _balls.vz[ball] * dt);
+	}
+
+	glm::quat EventPhysics::getOrientation(int ball) const {
+		// orientação extrapolada desde o último evento da bola (a velocidade é constante entre eventos)
+		float dt = (float)(_time - _ballTime[ball]);
+		glm::vec3 angularVelocity = getRollingAngularVelocity(getVelocity(ball)) + glm::vec3(_balls.wx[ball], _balls.wy[ball], _balls.wz[ball]);
+
+		return rotateOrientation(glm::quat(_balls.qw[ball], _balls.qx[ball], _balls.qy[ball], _balls.qz[ball]), angularVelocity, dt);
+	}
+
+	glm::vec3 EventPhysics::getVelocity(int ball) const {
+		return glm::vec3(_balls.vx[ball], _balls.vy[ball], _balls.vz[ball]);
+	}
+
+	const std::vector<Contact>& EventPhysics::getContacts() const {
+		return _contacts;
+	}
+
+	bool EventPhysics::isMoving() const {
+		for (int i = 0; i < _balls.count; i++) {
+			if (_balls.vx[i] != 0.0f || _balls.vy[i] != 0.0f || _balls.vz[i] != 0.0f ||
+				_balls.wx[i] != 0.0f || _balls.wy[i] != 0.0f || _balls.wz[i] != 0.0f) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	double EventPhysics::getTime() const {
+		return _time;
+	}
+
+	long long EventPhysics::getEventCount() const {
+		return _eventCount;
+	}
+
+	long long EventPhysics::getPredictionCount() const {
+		return _predictionCount;
+	}
+
+	// setters
+	void EventPhysics::setVelocity(int ball, glm::vec3 velocity) {
+		advanceBall(ball, _time);
+
+		_balls.vx[ball] = velocity.x;
+		_balls.vy[ball] = velocity.y;
+		_balls.vz[ball] = velocity.z;
+
+		// a trajetória mudou, por isso os eventos previstos para esta bola deixam de ser válidos
+		_versions[ball]++;
+		predict(ball);
+	}
+
+	void EventPhysics::setAngularVelocity(int ball, glm::vec3 angularVelocity) {
+		advanceBall(ball, _time);
+
+		_balls.wx[ball] = angularVelocity.x;
+		_balls.wy[ball] = angularVelocity.y;
+		_balls.wz[ball] = angularVelocity.z;
+	}
+
+#pragma endregion
+
+
+#pragma region construtor da classe EventPhysics
+
+	EventPhysics::EventPhysics() {
+		_balls.count = 0;
+		_time = 0.0;
+		_eventCount = 0;
+		_predictionCount = 0;
+	}
+
+#pragma endregion
+
+
+#pragma region funções principais da classe EventPhysics
+
+	int EventPhysics::addBall(glm::vec3 position, glm::quat orientation) {
+		_balls.x.push_back(position.x);
+		_balls.y.push_back(position.y);
+		_balls.z.push_back(position.z);
+		_balls.vx.push_back(0.0f);
+		_balls.vy.push_back(0.0f);
+		_balls.vz.push_back(0.0f);
+		_balls.qx.push_back(orientation.x);
+		_balls.qy.push_back(orientation.y);
+		_balls.qz.push_back(orientation.z);
+		_balls.qw.push_back(orientation.w);
+		_balls.wx.push_back(0.0f);
+		_balls.wy.push_back(0.0f);
+		_balls.wz.push_back(0.0f);
+		_ballTime.push_back(_time);
+		_versions.push_back(0);
+
+		return _balls.count++;
+	}
+
+	int EventPhysics::update(double frameTime) {
+		_contacts.clear();
+
+		long long eventCount = _eventCount;
+		run(_time + frameTime);
+
+		return (int)(_eventCount - eventCount);
+	}
+
+	void EventPhysics::simulate(double duration) {
+		_contacts.clear();
+		run(_time + duration);
+	}
+
+#pragma endregion
+
+
+#pragma region funções secundárias da classe EventPhysics
+
+	void EventPhysics::advanceBall(int ball, double time) {
+		float dt = (float)(time - _ballTime[ball]);
+
+		_balls.x[ball] += _balls.vx[ball] * dt;
+		_balls.y[ball] += _balls.vy[ball] * dt;
+		_balls.z[ball] += _balls.vz[ball] * dt;
+		glm::vec3 angularVelocity = getRollingAngularVelocity(getVelocity(ball)) + glm::vec3(_balls.wx[ball], _balls.wy[ball], _balls.wz[ball]);
+		glm::quat orientation = rotateOrientation(glm::quat(_balls.qw[ball], _balls.qx[ball], _balls.qy[ball], _balls.qz[ball]), angularVelocity, dt);
+		_balls.qx[ball] = orientation.x;
+		_balls.qy[ball] = orientation.y;
+		_balls.qz[ball] = orientation.z;
+		_balls.qw[ball] = orientation.w;
+		_ballTime[ball] = time;
+	}
+
+	void EventPhysics::predict(int ball) {
+		// colisões com as outras bolas
+		for (int other = 0; other < _balls.count; other++) {
+			if (other == ball) {
+				continue;
+			}
+
+			double t = timeToHit(ball, other);
+			if (t != NO_HIT) {
+				_events.push({ _time + t, ball, other, _versions[ball], _versions[other] });
+			}
+		}
+
+		_predictionCount += _balls.count - 1;
+
+		// colisões com as tabelas da mesa
+		double tx = timeToHitCushion(ball, CUSHION_X);
+		if (tx != NO_HIT) {
+			_events.push({ _time + tx, ball, CUSHION_X, _versions[ball], 0 });
+		}
+
+		double tz = timeToHitCushion(ball, CUSHION_Z);
+		if (tz != NO_HIT) {
+			_events.push({ _time + tz, ball, CUSHION_Z, _versions[ball], 0 });
+		}
+	}
+
+	double EventPhysics::timeToHit(int ballA, int ballB) const {
+		glm::vec3 positionA = getPosition(ballA);
+		glm::vec3 positionB = getPosition(ballB);
+
+		// posição e velocidade relativas (em precisão dupla, para o instante não derivar ao longo do tempo)
+		double dx = (double)positionB.x - positionA.x;
+		double dy = (double)positionB.y - positionA.y;
+		double dz = (double)positionB.z - positionA.z;
+		double dvx = (double)_balls.vx[ballB] - _balls.vx[ballA];
+		double dvy = (double)_balls.vy[ballB] - _balls.vy[ballA];
+		double dvz = (double)_balls.vz[ballB] - _balls.vz[ballA];
+
+		// se as bolas se estão a afastar
+		double dvdp = dx * dvx + dy * dvy + dz * dvz;
+		if (dvdp >= 0.0) {
+			return NO_HIT;
+		}
+
+		// resolve |dp + dv * t| = 2 * raio, ficando com a primeira raiz
+		double dvdv = dvx * dvx + dvy * dvy + dvz * dvz;
+		double dpdp = dx * dx + dy * dy + dz * dz;
+		double sigma = 2.0 * BALL_RADIUS;
+		double discriminant = dvdp * dvdp - dvdv * (dpdp - sigma * sigma);
+
+		// se as trajetórias não se cruzam
+		if (discriminant < 0.0) {
+			return NO_HIT;
+		}
+
+		double t = -(dvdp + std::sqrt(discriminant)) / dvdv;
+
+		// se já estão sobrepostas e a aproximar-se, colidem de imediato
+		return t < 0.0 ? 0.0 : t;
+	}
+
+	double EventPhysics::timeToHitCushion(int ball, int cushion) const {
+		glm::vec3 position = getPosition(ball);
+		double coord = cushion == CUSHION_X ? position.x : position.z;
+		double velocity = cushion == CUSHION_X ? _balls.vx[ball] : _balls.vz[ball];
+		double limit = (cushion == CUSHION_X ? TABLE_HALF_WIDTH : TABLE_HALF_DEPTH) - BALL_RADIUS;
+		double t;
+
+		if (velocity > 0.0) {
+			t = (limit - coord) / velocity;
+		}
+		else if (velocity < 0.0) {
+			t = (-limit - coord) / velocity;
+		}
+		else {
+			return NO_HIT;
+		}
+
+		return t < 0.0 ? 0.0 : t;
+	}
+
+	void EventPhysics::resolve(const CollisionEvent& event) {
+		int a = event.ballA;
+		int b = event.ballB;
+
+		advanceBall(a, _time);
+
+		// colisão com uma tabela da mesa: inverte a componente da velocidade perpendicular à tabela
+		if (b == CUSHION_X || b == CUSHION_Z) {
+			float& coord = b == CUSHION_X ? _balls.x[a] : _balls.z[a];
+			float& velocity = b == CUSHION_X ? _balls.vx[a] : _balls.vz[a];
+			float limit = (b == CUSHION_X ? TABLE_HALF_WIDTH : TABLE_HALF_DEPTH) - BALL_RADIUS;
+
+			coord = velocity > 0.0f ? limit : -limit;
+			velocity = -velocity;
+
+			_contacts.push_back({ a, -1 });
+			_versions[a]++;
+			predict(a);
+			return;
+		}
+
+		// colisão entre bolas: troca as componentes normais das velocidades (choque elástico, massas iguais)
+		advanceBall(b, _time);
+
+		glm::vec3 delta = glm::vec3(_balls.x[b] - _balls.x[a], _balls.y[b] - _balls.y[a], _balls.z[b] - _balls.z[a]);
+		glm::vec3 normal = glm::normalize(delta);
+		glm::vec3 velocityA = getVelocity(a);
+		glm::vec3 velocityB = getVelocity(b);
+		float approach = glm::dot(velocityA - velocityB, normal);
+
+		if (approach > 0.0f) {
+			velocityA -= normal * approach;
+			velocityB += normal * approach;
+
+			_balls.vx[a] = velocityA.x;
+			_balls.vy[a] = velocityA.y;
+			_balls.vz[a] = velocityA.z;
+			_balls.vx[b] = velocityB.x;
+			_balls.vy[b] = velocityB.y;
+			_balls.vz[b] = velocityB.z;
+
+			_contacts.push_back({ a, b });
+		}
+
+		// só as bolas envolvidas voltam a ser previstas
+		_versions[a]++;
+		_versions[b]++;
+		predict(a);
+		predict(b);
+	}
+
+	void EventPhysics::run(double endTime) {
+		while (!_events.empty() && _events.top().time <= endTime) {
+			CollisionEvent event = _events.top();
+			_events.pop();
+
+			// se alguma das bolas já colidiu depois de o evento ser previsto
+			if (event.versionA != _versions[event.ballA] ||
+				(event.ballB >= 0 && event.versionB != _versions[event.ballB])) {
+				continue;
+			}
+
+			_time = event.time;
+			_eventCount++;
+			resolve(event);
+		}
+
+		_time = endTime;
+	}
+
+#pragma endregion
+
+}
@@ -0,0 +1,105 @@
+/*
+ * @descrição	Ficheiro com todas as assinaturas relativas à simulação física orientada a eventos.
+ * @ficheiro	EventPhysics.h
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+*/
+
+
+#pragma once
+
+#ifndef EVENT_PHYSICS_H
+#define EVENT_PHYSICS_H 1
+
+#pragma region importações
+
+#include <vector>
+#include <queue>
+#include <functional>
+
+#include <glm\glm.hpp>
+
+#include "Physics.h"
+
+#pragma endregion
+
+
+#pragma region constantes
+
+#define CUSHION_X -1		// tabelas perpendiculares ao eixo X
+#define CUSHION_Z -2		// tabelas perpendiculares ao eixo Z
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region declarações da simulação por eventos
+
+	// estrutura de uma colisão prevista
+	typedef struct {
+		double time;		// instante previsto da colisão (segundos de simulação)
+		int ballA;			// índice da primeira bola
+		int ballB;			// índice da segunda bola, CUSHION_X ou CUSHION_Z
+		int versionA;		// número de colisões da primeira bola quando o evento foi previsto
+		int versionB;		// número de colisões da segunda bola quando o evento foi previsto
+	} CollisionEvent;
+
+	// ordena os eventos pelo instante (o mais próximo fica no topo da fila)
+	struct CollisionEventLater {
+		bool operator()(const CollisionEvent& a, const CollisionEvent& b) const {
+			return a.time > b.time;
+		}
+	};
+
+	// classe da simulação que salta diretamente de colisão em colisão
+	class EventPhysics : public Simulation {
+	private:
+		// atributos privados
+		BallStore _balls;							// estado de cada bola no instante _ballTime da própria bola
+		std::vector<double> _ballTime;				// instante a que corresponde o estado guardado de cada bola
+		std::vector<int> _versions;					// número de colisões de cada bola (invalida eventos antigos)
+		std::priority_queue<CollisionEvent, std::vector<CollisionEvent>, CollisionEventLater> _events;
+		std::vector<Contact> _contacts;				// contactos resolvidos na última atualização
+		double _time;								// instante atual da simulação
+		long long _eventCount;						// eventos válidos processados
+		long long _predictionCount;					// pares avaliados ao prever colisões
+
+		// secundárias
+		void advanceBall(int ball, double time);
+		void predict(int ball);
+		double timeToHit(int ballA, int ballB) const;
+		double timeToHitCushion(int ball, int cushion) const;
+		void resolve(const CollisionEvent& event);
+		void run(double endTime);
+
+	public:
+		// getters - obter valores de atributos fora da classe
+		int getNumberOfBalls() const override;
+		glm::vec3 getPosition(int ball) const override;
+		glm::quat getOrientation(int ball) const override;
+		glm::vec3 getVelocity(int ball) const override;
+		const std::vector<Contact>& getContacts() const override;
+		bool isMoving() const override;
+		double getTime() const;
+		long long getEventCount() const;
+		long long getPredictionCount() const;
+
+		// setters - definir valores de atributos fora da classe
+		void setVelocity(int ball, glm::vec3 velocity) override;
+		void setAngularVelocity(int ball, glm::vec3 angularVelocity) override;
+
+		// construtor
+		EventPhysics();
+
+		// principais
+		int addBall(glm::vec3 position, glm::quat orientation) override;
+		int update(double frameTime) override;
+		void simulate(double duration) override;
+	};
+
+#pragma endregion
+
+}
+
+#endif
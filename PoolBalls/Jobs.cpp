@@ -0,0 +1,337 @@
+﻿/*
+ * @descrição	Ficheiro com todo o código relativo ao sistema de tarefas (work stealing).
+ * @ficheiro	Jobs.cpp
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+ *
+ * -------------------------------------
+ *
+ * Cada worker tem a sua própria fila de tarefas. As tarefas submetidas por um worker vão para a sua fila,
+ * de onde ele as retira pelo fim (a mais recente, ainda quente na cache); um worker sem trabalho rouba
+ * pelo início da fila de outro (a mais antiga, normalmente a maior). As threads que não são workers
+ * (como a principal) partilham a fila 0 e, enquanto esperam por um grupo, ajudam a executar tarefas.
+*/
+
+
+#pragma region importações
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <condition_variable>
+
+#include "Jobs.h"
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region variáveis globais
+
+	// worker associado à thread atual (0 para as threads que não pertencem ao sistema)
+	static thread_local const JobSystem* _currentJobSystem = nullptr;
+	static thread_local int _currentWorker = 0;
+
+	// o sistema global é lido sem lock (getJobSystem é chamado em todos os passos da física);
+	// o mutex só protege a criação e a substituição
+	static std::unique_ptr<JobSystem> _jobSystem;
+	static std::atomic<JobSystem*> _activeJobSystem(nullptr);
+	static std::mutex _jobSystemMutex;
+
+#pragma endregion
+
+
+#pragma region funções da classe TaskGroup
+
+	bool TaskGroup::isDone() const {
+		return _pending.load() == 0;
+	}
+
+	TaskGroup::TaskGroup() : _pending(0), _hasContinuation(false) {
+	}
+
+#pragma endregion
+
+
+#pragma region funções getters da classe JobSystem
+
+	int JobSystem::getNumberOfWorkers() const {
+		return (int)_workers.size();
+	}
+
+	WorkerStats JobSystem::getWorkerStats(int worker) const {
+		WorkerStats stats;
+		stats.submitted = _workers[worker]->submitted.load();
+		stats.executed = _workers[worker]->executed.load();
+		stats.stolen = _workers[worker]->stolen.load();
+
+		return stats;
+	}
+
+#pragma endregion
+
+
+#pragma region construtor e destrutor da classe JobSystem
+
+	JobSystem::JobSystem(int numberOfThreads) : _running(true), _queuedTasks(0) {
+		// fila 0 para as threads externas, mais uma por worker
+		for (int i = 0; i <= numberOfThreads; i++) {
+			_workers.push_back(std::unique_ptr<Worker>(new Worker));
+			_workers[i]->submitted = 0;
+			_workers[i]->executed = 0;
+			_workers[i]->stolen = 0;
+		}
+
+		for (int i = 1; i <= numberOfThreads; i++) {
+			_threads.emplace_back(&JobSystem::workerLoop, this, i);
+		}
+	}
+
+	JobSystem::~JobSystem() {
+		// acorda os workers para terminarem
+		{
+			std::lock_guard<std::mutex> lock(_sleepMutex);
+			_running = false;
+		}
+		_wakeUp.notify_all();
+
+		for (std::thread& thread : _threads) {
+			thread.join();
+		}
+	}
+
+#pragma endregion
+
+
+#pragma region funções principais da classe JobSystem
+
+	void JobSystem::submit(TaskGroup& group, std::function<void(void)> job) {
+		int worker = getCurrentWorker();
+		group._pending++;
+
+		// coloca a tarefa no fim da fila do worker atual
+		{
+			std::lock_guard<std::mutex> lock(_workers[worker]->mutex);
+			_workers[worker]->tasks.push_back({ std::move(job), &group });
+		}
+		_workers[worker]->submitted++;
+
+		// acorda um worker que esteja a dormir
+		{
+			std::lock_guard<std::mutex> lock(_sleepMutex);
+			_queuedTasks++;
+		}
+		_wakeUp.notify_one();
+	}
+
+	void JobSystem::then(TaskGroup& group, std::function<void(void)> continuation) {
+		// a continuação conta como uma tarefa pendente até ser executada
+		group._pending++;
+		group._continuation = std::move(continuation);
+		group._hasContinuation = true;
+
+		// se as tarefas do grupo já terminaram todas, a continuação é executada já
+		if (group._pending.load() == 1 && group._hasContinuation.exchange(false)) {
+			std::function<void(void)> run = std::move(group._continuation);
+			run();
+			group._pending--;
+		}
+	}
+
+	void JobSystem::wait(TaskGroup& group) {
+		int worker = getCurrentWorker();
+
+		// ajuda a executar tarefas enquanto o grupo não termina
+		while (!group.isDone()) {
+			if (!runOneTask(worker)) {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void JobSystem::parallelFor(int begin, int end, int grainSize, std::function<void(int, int)> body) {
+		// se não compensa dividir o intervalo
+		if (end - begin <= grainSize || _threads.empty()) {
+			body(begin, end);
+			return;
+		}
+
+		// divide o intervalo em blocos de grainSize elementos
+		TaskGroup group;
+		for (int from = begin; from < end; from += grainSize) {
+			int to = std::min(from + grainSize, end);
+			submit(group, [&body, from, to]() {
+				body(from, to);
+			});
+		}
+
+		wait(group);
+	}
+
+	void JobSystem::resetStats(void) {
+		for (std::unique_ptr<Worker>& worker : _workers) {
+			worker->submitted = 0;
+			worker->executed = 0;
+			worker->stolen = 0;
+		}
+	}
+
+	void JobSystem::printStats(std::ostream& stream) const {
+		for (int i = 0; i < (int)_workers.size(); i++) {
+			WorkerStats stats = getWorkerStats(i);
+			stream << "worker " << i << (i == 0 ? " (externo)" : "") << ": "
+				<< stats.executed << " executadas, "
+				<< stats.stolen << " roubadas, "
+				<< stats.submitted << " submetidas" << std::endl;
+		}
+	}
+
+#pragma endregion
+
+
+#pragma region funções secundárias da classe JobSystem
+
+	int JobSystem::getCurrentWorker(void) const {
+		return _currentJobSystem == this ? _currentWorker : 0;
+	}
+
+	bool JobSystem::popTask(int worker, Task& task) {
+		std::lock_guard<std::mutex> lock(_workers[worker]->mutex);
+		std::deque<Task>& tasks = _workers[worker]->tasks;
+
+		if (tasks.empty()) {
+			return false;
+		}
+
+		// a tarefa mais recente
+		task = std::move(tasks.back());
+		tasks.pop_back();
+
+		return true;
+	}
+
+	bool JobSystem::stealTask(int worker, Task& task) {
+		int numberOfWorkers = (int)_workers.size();
+
+		// percorre as filas dos outros workers, a começar no seguinte
+		for (int i = 1; i < numberOfWorkers; i++) {
+			int victim = (worker + i) % numberOfWorkers;
+			std::lock_guard<std::mutex> lock(_workers[victim]->mutex);
+			std::deque<Task>& tasks = _workers[victim]->tasks;
+
+			if (!tasks.empty()) {
+				// a tarefa mais antiga
+				task = std::move(tasks.front());
+				tasks.pop_front();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool JobSystem::runOneTask(int worker) {
+		Task task;
+		bool stolen = false;
+
+		if (!popTask(worker, task)) {
+			if (!stealTask(worker, task)) {
+				return false;
+			}
+
+			stolen = true;
+		}
+
+		_queuedTasks--;
+
+		task.job();
+
+		_workers[worker]->executed++;
+		if (stolen) {
+			_workers[worker]->stolen++;
+		}
+
+		finishTask(task.group);
+
+		return true;
+	}
+
+	void JobSystem::finishTask(TaskGroup* group) {
+		int remaining = --group->_pending;
+
+		// se só falta a continuação, é executada por quem terminou a última tarefa
+		if (remaining == 1 && group->_hasContinuation.exchange(false)) {
+			std::function<void(void)> continuation = std::move(group->_continuation);
+			continuation();
+			group->_pending--;
+		}
+	}
+
+	void JobSystem::workerLoop(int worker) {
+		_currentJobSystem = this;
+		_currentWorker = worker;
+
+		while (true) {
+			if (runOneTask(worker)) {
+				continue;
+			}
+
+			// dorme até haver tarefas ou o sistema terminar
+			std::unique_lock<std::mutex> lock(_sleepMutex);
+			_wakeUp.wait(lock, [this]() {
+				return _queuedTasks.load() > 0 || !_running;
+			});
+
+			if (!_running) {
+				return;
+			}
+		}
+	}
+
+#pragma endregion
+
+
+#pragma region funções globais do sistema de tarefas
+
+	static int getDefaultNumberOfThreads(void) {
+		// a thread que chama também executa tarefas, por isso cria um worker a menos do que núcleos
+		return std::max(0, (int)std::thread::hardware_concurrency() - 1);
+	}
+
+	void startJobSystem(int numberOfThreads) {
+		std::lock_guard<std::mutex> lock(_jobSystemMutex);
+
+		if (numberOfThreads < 0) {
+			numberOfThreads = getDefaultNumberOfThreads();
+		}
+
+		_jobSystem.reset(new JobSystem(numberOfThreads));
+		_activeJobSystem.store(_jobSystem.get(), std::memory_order_release);
+	}
+
+	JobSystem& getJobSystem(void) {
+		JobSystem* jobSystem = _activeJobSystem.load(std::memory_order_acquire);
+		if (jobSystem) {
+			return *jobSystem;
+		}
+
+		// cria o sistema com um worker por núcleo na primeira utilização (só aqui é preciso o lock)
+		std::lock_guard<std::mutex> lock(_jobSystemMutex);
+		if (!_jobSystem) {
+			_jobSystem.reset(new JobSystem(getDefaultNumberOfThreads()));
+			_activeJobSystem.store(_jobSystem.get(), std::memory_order_release);
+		}
+
+		return *_jobSystem;
+	}
+
+#pragma endregion
+
+}
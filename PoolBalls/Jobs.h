@@ -0,0 +1,123 @@
+/*
+ * @descrição	Ficheiro com todas as assinaturas relativas ao sistema de tarefas (work stealing).
+ * @ficheiro	Jobs.h
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+*/
+
+
+#pragma once
+
+#ifndef JOBS_H
+#define JOBS_H 1
+
+#pragma region importações
+
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <condition_variable>
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region declarações do sistema de tarefas
+
+	class JobSystem;
+
+	// estrutura com as estatísticas de cada worker
+	typedef struct {
+		long long submitted;	// tarefas colocadas na fila do worker
+		long long executed;		// tarefas executadas pelo worker
+		long long stolen;		// tarefas executadas que foram roubadas da fila de outro worker
+	} WorkerStats;
+
+	// classe de um grupo de tarefas, para esperar por todas ou encadear uma continuação
+	class TaskGroup {
+	private:
+		// atributos privados
+		std::atomic<int> _pending;					// tarefas ainda por terminar (mais 1 enquanto houver continuação)
+		std::atomic<bool> _hasContinuation;
+		std::function<void(void)> _continuation;
+
+		friend class JobSystem;
+
+	public:
+		// getters - obter valores de atributos fora da classe
+		bool isDone() const;
+
+		// construtor
+		TaskGroup();
+	};
+
+	// classe do sistema de tarefas: cada worker tem a sua fila, tira tarefas do fim da própria fila
+	// e, quando fica sem trabalho, rouba do início da fila de outro worker
+	class JobSystem {
+	private:
+		// estrutura de uma tarefa
+		typedef struct {
+			std::function<void(void)> job;
+			TaskGroup* group;
+		} Task;
+
+		// estrutura de um worker (o índice 0 é partilhado pelas threads que não são workers, como a principal)
+		typedef struct {
+			std::mutex mutex;
+			std::deque<Task> tasks;
+			std::atomic<long long> submitted;
+			std::atomic<long long> executed;
+			std::atomic<long long> stolen;
+		} Worker;
+
+		// atributos privados
+		std::vector<std::unique_ptr<Worker>> _workers;
+		std::vector<std::thread> _threads;
+		std::atomic<bool> _running;
+		std::atomic<int> _queuedTasks;
+		std::mutex _sleepMutex;
+		std::condition_variable _wakeUp;
+
+		// secundárias
+		int getCurrentWorker(void) const;
+		bool popTask(int worker, Task& task);
+		bool stealTask(int worker, Task& task);
+		bool runOneTask(int worker);
+		void finishTask(TaskGroup* group);
+		void workerLoop(int worker);
+
+	public:
+		// getters - obter valores de atributos fora da classe
+		int getNumberOfWorkers() const;
+		WorkerStats getWorkerStats(int worker) const;
+
+		// construtor
+		JobSystem(int numberOfThreads);
+
+		// destrutor
+		~JobSystem();
+
+		// principais
+		void submit(TaskGroup& group, std::function<void(void)> job);
+		void then(TaskGroup& group, std::function<void(void)> continuation);
+		void wait(TaskGroup& group);
+		void parallelFor(int begin, int end, int grainSize, std::function<void(int, int)> body);
+		void resetStats(void);
+		void printStats(std::ostream& stream) const;
+	};
+
+	// funções globais do sistema de tarefas
+	void startJobSystem(int numberOfThreads);
+	JobSystem& getJobSystem(void);
+
+#pragma endregion
+
+}
+
+#endif
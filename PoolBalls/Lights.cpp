@@ -0,0 +1,243 @@
+﻿/*
+ * @descrição	Ficheiro com todo o código relativo à lista de luzes e à sua seleção por tiles do ecrã.
+ * @ficheiro	Lights.cpp
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+ *
+ * -------------------------------------
+ *
+ * Os modelos de luz 1 a 4 usam uma só luz, escolhida ao compilar a variante. O modelo LIGHT_MODEL_MULTIPLE
+ * usa todas as luzes da lista, guardada num SSBO. Para o custo por fragmento não crescer com o número de luzes,
+ * o ecrã é dividido em tiles de LIGHT_TILE_SIZE x LIGHT_TILE_SIZE píxeis e, antes de desenhar, o compute shader
+ * LightCulling.comp testa a esfera de alcance de cada luz contra a pirâmide de visão de cada tile. O fragment
+ * shader só percorre as luzes do seu tile.
+*/
+
+
+#pragma region importações
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#define GLEW_STATIC
+#include <GL\glew.h>
+
+#define GLFW_USE_DWM_SWAP_INTERVAL
+#include <GLFW\glfw3.h>
+
+#include <glm\glm.hpp>
+
+#include "Shaders.h"
+#include "UniformBuffers.h"
+#include "Memory.h"
+#include "Lights.h"
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region funções getters da classe TiledLights
+
+	int TiledLights::getNumberOfLights() const {
+		return (int)_lights.size();
+	}
+
+	int TiledLights::getNumberOfTiles() const {
+		return _tilesX * _tilesY;
+	}
+
+	glm::ivec4 TiledLights::getLightingInfo() const {
+		// dados lidos pelos shaders no bloco FrameData
+		return glm::ivec4((int)_lights.size(), _tilesX, _width, _height);
+	}
+
+	bool TiledLights::isValid() const {
+		// só com o compute shader e o buffer das tiles é que os blocos LightList e TileLights ficam ligados
+		return _cullingProgram.isValid() && _tileBuffer != 0;
+	}
+
+#pragma endregion
+
+
+#pragma region construtor e destrutor da classe TiledLights
+
+	TiledLights::TiledLights() {
+		_tileBuffer = 0;
+		_width = 0;
+		_height = 0;
+		_tilesX = 0;
+		_tilesY = 0;
+	}
+
+	TiledLights::~TiledLights() {
+		// o buffer só pode ser apagado enquanto existir um contexto OpenGL
+		if (_tileBuffer && glfwGetCurrentContext()) {
+			trackGpuMemory(MEMORY_BUFFERS, -(long long)((size_t)_tilesX * _tilesY * (MAX_LIGHTS_PER_TILE + 1) * sizeof(GLuint)));
+			glDeleteBuffers(1, &_tileBuffer);
+		}
+	}
+
+#pragma endregion
+
+
+#pragma region funções principais da classe TiledLights
+
+	int TiledLights::addDirectionalLight(glm::vec3 direction, glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular) {
+		LightData light = {};
+		light.position = glm::vec4(0.0f, 0.0f, 0.0f, (float)LIGHT_DIRECTIONAL);
+		light.direction = glm::vec4(direction, 0.0f);
+		light.ambient = glm::vec4(ambient, 0.0f);
+		light.diffuse = glm::vec4(diffuse, 0.0f);
+		light.specular = glm::vec4(specular, 0.0f);
+		light.attenuation = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+
+		return add(light);
+	}
+
+	int TiledLights::addPointLight(glm::vec3 position, glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular, float constant, float linear, float quadratic) {
+		LightData light = {};
+		light.position = glm::vec4(position, (float)LIGHT_POINT);
+		light.ambient = glm::vec4(ambient, 0.0f);
+		light.diffuse = glm::vec4(diffuse, 0.0f);
+		light.specular = glm::vec4(specular, 0.0f);
+		light.attenuation = glm::vec4(constant, linear, quadratic, 0.0f);
+
+		return add(light);
+	}
+
+	int TiledLights::addSpotLight(glm::vec3 position, glm::vec3 direction, glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular, float constant, float linear, float quadratic, float cutOff, float outerCutOff) {
+		LightData light = {};
+		light.position = glm::vec4(position, (float)LIGHT_SPOT);
+		light.direction = glm::vec4(direction, 0.0f);
+		light.ambient = glm::vec4(ambient, 0.0f);
+		light.diffuse = glm::vec4(diffuse, 0.0f);
+		light.specular = glm::vec4(specular, 0.0f);
+		light.attenuation = glm::vec4(constant, linear, quadratic, 0.0f);
+		light.cone = glm::vec4(cutOff, outerCutOff, 0.0f, 0.0f);
+
+		return add(light);
+	}
+
+	bool TiledLights::create(int width, int height) {
+		_width = width;
+		_height = height;
+		_tilesX = (width + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+		_tilesY = (height + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+
+		// compute shader que escolhe as luzes de cada tile
+		ShaderInfo shaders[] = {
+			{ GL_COMPUTE_SHADER, "shaders/LightCulling.comp" },
+			{ GL_NONE, NULL }
+		};
+
+		std::string defines = getTiledLightingDefines();
+		_cullingProgram = loadShaders(shaders, defines.c_str(), nullptr);
+
+		// se houve erros ao carregar o compute shader
+		if (!_cullingProgram.isValid()) {
+			return false;
+		}
+
+		// buffer com todas as luzes (tamanho fixo, atualizado só quando a lista muda)
+		_lightBuffer.create(GL_SHADER_STORAGE_BUFFER, LIGHTS_STORAGE_BINDING, MAX_LIGHTS * sizeof(LightData));
+
+		// buffer com a lista de cada tile, escrito só pela GPU
+		glGenBuffers(1, &_tileBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, _tileBuffer);
+		glBufferStorage(GL_SHADER_STORAGE_BUFFER, (size_t)_tilesX * _tilesY * (MAX_LIGHTS_PER_TILE + 1) * sizeof(GLuint), nullptr, 0);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TILE_LIGHTS_STORAGE_BINDING, _tileBuffer);
+		trackGpuMemory(MEMORY_BUFFERS, (long long)((size_t)_tilesX * _tilesY * (MAX_LIGHTS_PER_TILE + 1) * sizeof(GLuint)));
+
+		return true;
+	}
+
+	void TiledLights::Send(void) {
+		// uma só escrita com a lista toda (ignorada se nada mudou)
+		if (!_lights.empty()) {
+			_lightBuffer.update(_lights.data(), _lights.size() * sizeof(LightData));
+		}
+	}
+
+	void TiledLights::Cull(void) {
+		// se o compute shader não foi carregado
+		if (!_cullingProgram.isValid()) {
+			return;
+		}
+
+		// o programa de desenho é vinculado de novo por quem desenha a seguir
+		_lightBuffer.Bind();
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TILE_LIGHTS_STORAGE_BINDING, _tileBuffer);
+		glUseProgram(_cullingProgram.getId());
+
+		// um grupo de trabalho por tile
+		glDispatchCompute(_tilesX, _tilesY, 1);
+
+		// as listas têm de estar escritas antes de os fragment shaders as lerem
+		glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+	}
+
+#pragma endregion
+
+
+#pragma region funções secundárias da classe TiledLights
+
+	int TiledLights::add(const LightData& light) {
+		// se a lista está cheia
+		if ((int)_lights.size() >= MAX_LIGHTS) {
+			std::cerr << "Lista de luzes cheia (" << MAX_LIGHTS << " luzes)." << std::endl;
+			return -1;
+		}
+
+		_lights.push_back(light);
+		_lights.back().direction.w = getLightRange(light);
+
+		return (int)_lights.size() - 1;
+	}
+
+#pragma endregion
+
+
+#pragma region funções globais da lista de luzes
+
+	std::string getTiledLightingDefines(void) {
+		// as constantes partilhadas com os shaders são injetadas no código, para não haver duas cópias
+		return "#define LIGHT_TILE_SIZE " + std::to_string(LIGHT_TILE_SIZE) + "\n"
+			"#define MAX_LIGHTS_PER_TILE " + std::to_string(MAX_LIGHTS_PER_TILE) + "\n"
+			"#define LIGHT_DIRECTIONAL " + std::to_string(LIGHT_DIRECTIONAL) + "\n"
+			"#define LIGHT_POINT " + std::to_string(LIGHT_POINT) + "\n"
+			"#define LIGHT_SPOT " + std::to_string(LIGHT_SPOT) + "\n";
+	}
+
+	float getLightRange(const LightData& light) {
+		// a luz direcional ilumina a cena toda
+		if ((int)light.position.w == LIGHT_DIRECTIONAL) {
+			return -1.0f;
+		}
+
+		// distância a que a componente mais forte da luz, atenuada, desce abaixo do limiar:
+		// intensidade / (c + l * d + q * d^2) = limiar  <=>  q * d^2 + l * d + (c - intensidade / limiar) = 0
+		float intensity = std::max({ light.ambient.x, light.ambient.y, light.ambient.z, light.diffuse.x, light.diffuse.y, light.diffuse.z, light.specular.x, light.specular.y, light.specular.z });
+		float c = light.attenuation.x - intensity / LIGHT_ATTENUATION_THRESHOLD;
+		float l = light.attenuation.y;
+		float q = light.attenuation.z;
+
+		// se a luz já começa abaixo do limiar, não ilumina nada
+		if (c >= 0.0f) {
+			return 0.0f;
+		}
+
+		// sem atenuação quadrática, a equação é linear (e sem nenhuma atenuação o alcance é infinito)
+		if (q <= 0.0f) {
+			return l > 0.0f ? -c / l : -1.0f;
+		}
+
+		return (-l + std::sqrt(l * l - 4.0f * q * c)) / (2.0f * q);
+	}
+
+#pragma endregion
+
+}
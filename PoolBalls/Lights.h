@@ -0,0 +1,111 @@
+/*
+ * @descrição	Ficheiro com todas as assinaturas relativas à lista de luzes e à sua seleção por tiles do ecrã.
+ * @ficheiro	Lights.h
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+*/
+
+
+#pragma once
+
+#ifndef LIGHTS_H
+#define LIGHTS_H 1
+
+#pragma region importações
+
+#include <string>
+#include <vector>
+
+#define GLEW_STATIC
+#include <GL\glew.h>
+
+#include <glm\glm.hpp>
+
+#include "Shaders.h"
+#include "UniformBuffers.h"
+
+#pragma endregion
+
+
+#pragma region constantes
+
+#define LIGHT_MODEL_MULTIPLE 5				// modelo de luz que usa a lista de luzes (os modelos 1 a 4 usam uma só luz)
+#define MAX_LIGHTS 256						// luzes que cabem na lista
+#define LIGHT_TILE_SIZE 16					// lado de cada tile do ecrã, em píxeis (e do grupo de trabalho do compute shader)
+#define MAX_LIGHTS_PER_TILE 64				// luzes que cabem na lista de cada tile
+#define LIGHT_ATTENUATION_THRESHOLD 0.02f	// intensidade abaixo da qual a luz é desprezada (define o alcance)
+#define LIGHTS_STORAGE_BINDING 3			// binding do bloco LightList (SSBO)
+#define TILE_LIGHTS_STORAGE_BINDING 4		// binding do bloco TileLights (SSBO)
+
+#define LIGHT_DIRECTIONAL 0
+#define LIGHT_POINT 1
+#define LIGHT_SPOT 2
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region declarações da lista de luzes
+
+	// estrutura de uma luz da lista (std430, igual a LightData nos shaders)
+	typedef struct {
+		glm::vec4 position;			// xyz: posição (espaço do mundo), w: tipo (LIGHT_DIRECTIONAL, LIGHT_POINT ou LIGHT_SPOT)
+		glm::vec4 direction;		// xyz: direção (espaço do mundo), w: alcance (negativo se é infinito)
+		glm::vec4 ambient;			// xyz: componente de luz ambiente
+		glm::vec4 diffuse;			// xyz: componente de luz difusa
+		glm::vec4 specular;			// xyz: componente de luz especular
+		glm::vec4 attenuation;		// x: constante, y: linear, z: quadrática
+		glm::vec4 cone;				// x: cosseno do ângulo interior, y: cosseno do ângulo exterior
+	} LightData;
+
+	static_assert(sizeof(LightData) == 112, "LightData não segue a disposição std430");
+
+	// classe da lista de luzes da cena: todas as luzes ficam num SSBO e, em cada frame, um compute shader
+	// escolhe para cada tile do ecrã as luzes que o podem iluminar, para o custo por fragmento não crescer com a cena
+	class TiledLights {
+	private:
+		// atributos privados
+		std::vector<LightData> _lights;
+		UniformBuffer _lightBuffer;		// SSBO com todas as luzes
+		GLuint _tileBuffer;				// SSBO com as luzes de cada tile (número de luzes seguido dos índices)
+		ShaderProgram _cullingProgram;
+		int _width;
+		int _height;
+		int _tilesX;
+		int _tilesY;
+
+		// secundárias
+		int add(const LightData& light);
+
+	public:
+		// getters - obter valores de atributos fora da classe
+		int getNumberOfLights() const;
+		int getNumberOfTiles() const;
+		glm::ivec4 getLightingInfo() const;
+		bool isValid() const;
+
+		// construtor
+		TiledLights();
+
+		// destrutor
+		~TiledLights();
+
+		// principais
+		int addDirectionalLight(glm::vec3 direction, glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular);
+		int addPointLight(glm::vec3 position, glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular, float constant, float linear, float quadratic);
+		int addSpotLight(glm::vec3 position, glm::vec3 direction, glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular, float constant, float linear, float quadratic, float cutOff, float outerCutOff);
+		bool create(int width, int height);
+		void Send(void);
+		void Cull(void);
+	};
+
+	// funções globais da lista de luzes
+	std::string getTiledLightingDefines(void);
+	float getLightRange(const LightData& light);
+
+#pragma endregion
+
+}
+
+#endif
@@ -0,0 +1,172 @@
+﻿/*
+ * @descrição	Ficheiro com todo o código relativo ao mapeamento de ficheiros em memória.
+ * @ficheiro	MappedFile.cpp
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+*/
+
+
+#pragma region importações
+
+#include <cstddef>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#include "MappedFile.h"
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region funções getters da classe MappedFile
+
+	const unsigned char* MappedFile::getData() const {
+		return _data;
+	}
+
+	size_t MappedFile::getSize() const {
+		return _size;
+	}
+
+	bool MappedFile::isOpen() const {
+		return _data != nullptr;
+	}
+
+#pragma endregion
+
+
+#pragma region construtor e destrutor da classe MappedFile
+
+#ifdef _WIN32
+	MappedFile::MappedFile() : _data(nullptr), _size(0), _file(INVALID_HANDLE_VALUE), _mapping(nullptr) {
+	}
+#else
+	MappedFile::MappedFile() : _data(nullptr), _size(0), _descriptor(-1) {
+	}
+#endif
+
+	MappedFile::~MappedFile() {
+		close();
+	}
+
+#pragma endregion
+
+
+#pragma region funções principais da classe MappedFile
+
+	bool MappedFile::open(const char* filepath) {
+		close();
+
+#ifdef _WIN32
+		_file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (_file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0) {
+			close();
+			return false;
+		}
+
+		_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!_mapping) {
+			close();
+			return false;
+		}
+
+		_data = (const unsigned char*)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+		_size = (size_t)size.QuadPart;
+#else
+		_descriptor = ::open(filepath, O_RDONLY);
+		if (_descriptor < 0) {
+			return false;
+		}
+
+		struct stat info;
+		if (fstat(_descriptor, &info) != 0 || info.st_size == 0) {
+			close();
+			return false;
+		}
+
+		void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, _descriptor, 0);
+		_data = data == MAP_FAILED ? nullptr : (const unsigned char*)data;
+		_size = (size_t)info.st_size;
+#endif
+
+		// se não foi possível mapear o ficheiro
+		if (!_data) {
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void MappedFile::close(void) {
+#ifdef _WIN32
+		if (_data) {
+			UnmapViewOfFile(_data);
+		}
+		if (_mapping) {
+			CloseHandle(_mapping);
+		}
+		if (_file != INVALID_HANDLE_VALUE) {
+			CloseHandle(_file);
+		}
+
+		_mapping = nullptr;
+		_file = INVALID_HANDLE_VALUE;
+#else
+		if (_data) {
+			munmap((void*)_data, _size);
+		}
+		if (_descriptor >= 0) {
+			::close(_descriptor);
+		}
+
+		_descriptor = -1;
+#endif
+
+		_data = nullptr;
+		_size = 0;
+	}
+
+#pragma endregion
+
+
+#pragma region funções globais do mapeamento de ficheiros
+
+	bool getFileInfo(const char* filepath, long long* size, long long* modificationTime) {
+#ifdef _WIN32
+		struct _stat64 info;
+		if (_stat64(filepath, &info) != 0) {
+			return false;
+		}
+#else
+		struct stat info;
+		if (stat(filepath, &info) != 0) {
+			return false;
+		}
+#endif
+
+		*size = (long long)info.st_size;
+		*modificationTime = (long long)info.st_mtime;
+
+		return true;
+	}
+
+#pragma endregion
+
+}
@@ -0,0 +1,62 @@
+/*
+ * @descrição	Ficheiro com todas as assinaturas relativas ao mapeamento de ficheiros em memória.
+ * @ficheiro	MappedFile.h
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+*/
+
+
+#pragma once
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H 1
+
+#pragma region importações
+
+#include <cstddef>
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region declarações do mapeamento de ficheiros
+
+	// classe de um ficheiro mapeado só para leitura (o conteúdo é lido pelo sistema operativo à medida que é acedido)
+	class MappedFile {
+	private:
+		// atributos privados
+		const unsigned char* _data;
+		size_t _size;
+#ifdef _WIN32
+		void* _file;		// HANDLE do ficheiro
+		void* _mapping;		// HANDLE do mapeamento
+#else
+		int _descriptor;
+#endif
+
+	public:
+		// getters - obter valores de atributos fora da classe
+		const unsigned char* getData() const;
+		size_t getSize() const;
+		bool isOpen() const;
+
+		// construtor
+		MappedFile();
+
+		// destrutor
+		~MappedFile();
+
+		// principais
+		bool open(const char* filepath);
+		void close(void);
+	};
+
+	// funções globais do mapeamento de ficheiros
+	bool getFileInfo(const char* filepath, long long* size, long long* modificationTime);
+
+#pragma endregion
+
+}
+
+#endif
@@ -0,0 +1,87 @@
+﻿/*
+ * @descrição	Ficheiro com todo o código relativo à contabilização da memória usada pelos recursos.
+ * @ficheiro	Memory.cpp
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+ *
+ * -------------------------------------
+ *
+ * Cada recurso regista a memória que ocupa quando é criado e retira-a quando é libertado, separada entre
+ * a memória do processo (CPU) e a dos objetos OpenGL (GPU). Os dados que só servem para enviar um recurso
+ * para a GPU (vértices lidos do .obj, níveis de mipmap cozidos, ficheiros mapeados) são libertados logo
+ * depois do envio, por isso, com a cena carregada, a memória da CPU deve ficar perto de zero nas malhas e
+ * nas texturas. Os contadores são atómicos, porque os recursos são lidos pelas threads do sistema de tarefas.
+*/
+
+
+#pragma region importações
+
+#include <iostream>
+#include <atomic>
+
+#include "Memory.h"
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region variáveis da contabilização de memória
+
+	static std::atomic<long long> _cpuBytes[NUMBER_OF_MEMORY_CATEGORIES];
+	static std::atomic<long long> _gpuBytes[NUMBER_OF_MEMORY_CATEGORIES];
+
+	static const char* CATEGORY_NAMES[NUMBER_OF_MEMORY_CATEGORIES] = {
+		"malhas",
+		"texturas",
+		"buffers",
+		"envio de texturas"
+	};
+
+#pragma endregion
+
+
+#pragma region funções globais da contabilização de memória
+
+	void trackCpuMemory(int category, long long bytes) {
+		_cpuBytes[category] += bytes;
+	}
+
+	void trackGpuMemory(int category, long long bytes) {
+		_gpuBytes[category] += bytes;
+	}
+
+	MemoryUsage getMemoryUsage(int category) {
+		return { _cpuBytes[category].load(), _gpuBytes[category].load() };
+	}
+
+	MemoryUsage getTotalMemoryUsage(void) {
+		MemoryUsage total = { 0, 0 };
+
+		for (int i = 0; i < NUMBER_OF_MEMORY_CATEGORIES; i++) {
+			total.cpuBytes += _cpuBytes[i].load();
+			total.gpuBytes += _gpuBytes[i].load();
+		}
+
+		return total;
+	}
+
+	const char* getMemoryCategoryName(int category) {
+		return CATEGORY_NAMES[category];
+	}
+
+	void printMemoryUsage(void) {
+		std::cout << "Memoria (CPU / GPU):" << std::endl;
+
+		for (int i = 0; i < NUMBER_OF_MEMORY_CATEGORIES; i++) {
+			MemoryUsage usage = getMemoryUsage(i);
+			std::cout << "  " << getMemoryCategoryName(i) << ": " << usage.cpuBytes / 1024 << " KB / " << usage.gpuBytes / 1024 << " KB" << std::endl;
+		}
+
+		MemoryUsage total = getTotalMemoryUsage();
+		std::cout << "  total: " << total.cpuBytes / 1024 << " KB / " << total.gpuBytes / 1024 << " KB" << std::endl;
+	}
+
+#pragma endregion
+
+}
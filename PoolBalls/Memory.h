@@ -0,0 +1,47 @@
+/*
+ * @descrição	Ficheiro com todas as assinaturas relativas à contabilização da memória usada pelos recursos.
+ * @ficheiro	Memory.h
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+*/
+
+
+#pragma once
+
+#ifndef MEMORY_H
+#define MEMORY_H 1
+
+#pragma region constantes
+
+#define MEMORY_MESHES 0					// vértices e índices das malhas (mesa incluída)
+#define MEMORY_TEXTURES 1				// níveis de mipmap das imagens e posição de cada imagem na textura partilhada
+#define MEMORY_BUFFERS 2				// uniform blocks e SSBOs (câmara, luzes, materiais e instâncias)
+#define MEMORY_UPLOAD 3					// anel de envio de texturas (mapeado, visível pela CPU e pela GPU; só existe durante um envio)
+#define NUMBER_OF_MEMORY_CATEGORIES 4
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region declarações da contabilização de memória
+
+	// estrutura com a memória usada por uma categoria de recursos
+	typedef struct {
+		long long cpuBytes;		// memória do processo (incluindo ficheiros mapeados)
+		long long gpuBytes;		// buffers e texturas criados no OpenGL
+	} MemoryUsage;
+
+	// funções globais da contabilização de memória (bytes positivos ao alocar, negativos ao libertar)
+	void trackCpuMemory(int category, long long bytes);
+	void trackGpuMemory(int category, long long bytes);
+	MemoryUsage getMemoryUsage(int category);
+	MemoryUsage getTotalMemoryUsage(void);
+	const char* getMemoryCategoryName(int category);
+	void printMemoryUsage(void);
+
+#pragma endregion
+
+}
+
+#endif
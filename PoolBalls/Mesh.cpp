@@ -0,0 +1,754 @@
+﻿/*
+ * @descrição	Ficheiro com todo o código relativo ao registo de malhas partilhadas.
+ * @ficheiro	Mesh.cpp
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+ *
+ * -------------------------------------
+ *
+ * Os ficheiros Ball1.obj a Ball15.obj têm a mesma esfera e só diferem no material (linhas mtllib e usemtl).
+ * Antes de interpretar um .obj, é calculado um hash apenas das linhas de geometria (v, vt, vn e f); se já
+ * existir uma malha com esse hash, é reutilizada. Assim, a esfera é interpretada e enviada para a GPU uma vez
+ * e todas as bolas desenham a partir do mesmo VAO/VBO.
+ *
+ * Ao interpretar o .obj, os vértices com a mesma posição, normal e coordenadas de textura são soldados
+ * num único vértice e as faces passam a referenciá-lo por índice (desenho com glDrawElements). Os índices
+ * são de 16 bits quando a malha tem até 65536 vértices únicos.
+ *
+ * O .obj é mapeado em memória e lido em duas passagens: a primeira só conta as linhas v, vt, vn e os cantos
+ * das faces, o que dá o tamanho exato de todos os arrays (posições, vértices de saída, índices e tabela da
+ * soldadura); a segunda preenche-os. Todos os arrays vêm de uma arena reservada de uma só vez, por isso ler
+ * uma malha faz um punhado de alocações em vez de uma por linha e por vértice (strings, streams e
+ * std::vector a crescer), e a arena inteira é libertada de uma vez depois do envio para a GPU.
+ *
+ * Depois de interpretado, cada .obj é guardado num ficheiro binário ao lado (<nome>.obj.mesh) com um
+ * cabeçalho (hash da geometria, tamanho e data do .obj de origem, descritor dos atributos e nome do .mtl)
+ * seguido dos vértices e índices já no formato da GPU. Nos arranques seguintes, se o cabeçalho corresponder
+ * ao .obj atual, o ficheiro é mapeado em memória e enviado diretamente para glBufferStorage, sem ler o .obj.
+ *
+ * Cada bola guarda um MeshHandle, que conta as referências à malha; quando a última é libertada, a malha
+ * é removida do registo e os seus buffers são apagados. Os vértices e índices na memória da CPU (ou o
+ * ficheiro de cache mapeado) só servem para o envio, por isso são libertados logo depois de glBufferStorage.
+*/
+
+
+#pragma region importações
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <mutex>
+
+#define GLEW_STATIC
+#include <GL\glew.h>
+
+#define GLFW_USE_DWM_SWAP_INTERVAL
+#include <GLFW\glfw3.h>
+
+#include <glm\glm.hpp>
+
+#include "Arena.h"
+#include "TextParser.h"
+#include "MappedFile.h"
+#include "Culling.h"
+#include "Memory.h"
+#include "Mesh.h"
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region constantes
+
+	static const unsigned long long FNV_OFFSET_BASIS = 14695981039346656037ULL;
+	static const unsigned long long FNV_PRIME = 1099511628211ULL;
+	static const unsigned int WELD_EMPTY = 0xFFFFFFFF;		// posição livre na tabela da soldadura
+
+	// disposição dos vértices: posição, normal e coordenadas de textura
+	static const MeshAttribute VERTEX_LAYOUT[MESH_VERTEX_ATTRIBUTES] = {
+		{ 0, 3, 0 },
+		{ 1, 3, 3 },
+		{ 2, 2, 6 }
+	};
+
+#pragma endregion
+
+
+#pragma region estruturas da soldadura de vértices
+
+	// atributos de um vértice, comparados bit a bit para encontrar vértices repetidos
+	typedef struct {
+		float data[MESH_VERTEX_SIZE];
+	} WeldKey;
+
+	static bool operator==(const WeldKey& a, const WeldKey& b) {
+		return std::memcmp(a.data, b.data, sizeof(a.data)) == 0;
+	}
+
+	static size_t hashWeldKey(const WeldKey& key) {
+		const unsigned char* bytes = (const unsigned char*)key.data;
+		unsigned long long hash = FNV_OFFSET_BASIS;
+
+		for (size_t i = 0; i < sizeof(key.data); i++) {
+			hash = (hash ^ bytes[i]) * FNV_PRIME;
+		}
+
+		return (size_t)hash;
+	}
+
+#pragma endregion
+
+
+#pragma region funções auxiliares do registo de malhas
+
+	// memória da CPU com os dados da malha ainda por enviar (arena com o .obj interpretado ou ficheiro de cache mapeado)
+	static long long getStagingBytes(const Mesh* mesh) {
+		long long bytes = 0;
+
+		if (mesh->arena) {
+			bytes += (long long)mesh->arena->getReservedBytes();
+		}
+		if (mesh->cacheFile) {
+			bytes += (long long)mesh->cacheFile->getSize();
+		}
+
+		return bytes;
+	}
+
+	static void releaseStaging(Mesh* mesh) {
+		trackCpuMemory(MEMORY_MESHES, -getStagingBytes(mesh));
+
+		delete mesh->arena;
+		delete mesh->cacheFile;
+		mesh->arena = nullptr;
+		mesh->cacheFile = nullptr;
+		mesh->vertices = nullptr;
+		mesh->indices = nullptr;
+	}
+
+#pragma endregion
+
+
+#pragma region funções getters da classe MeshHandle
+
+	Mesh* MeshHandle::getMesh() const {
+		return _mesh;
+	}
+
+	bool MeshHandle::isValid() const {
+		return _mesh != nullptr;
+	}
+
+#pragma endregion
+
+
+#pragma region construtores, destrutor e operadores da classe MeshHandle
+
+	MeshHandle::MeshHandle() : _mesh(nullptr) {
+	}
+
+	MeshHandle::MeshHandle(Mesh* mesh) : _mesh(mesh) {
+		if (_mesh) {
+			getMeshRegistry().retain(_mesh);
+		}
+	}
+
+	MeshHandle::MeshHandle(const MeshHandle& other) : MeshHandle(other._mesh) {
+	}
+
+	MeshHandle::~MeshHandle() {
+		if (_mesh) {
+			getMeshRegistry().release(_mesh);
+		}
+	}
+
+	MeshHandle& MeshHandle::operator=(const MeshHandle& other) {
+		// incrementa antes de decrementar, para a atribuição a si próprio não libertar a malha
+		if (other._mesh) {
+			getMeshRegistry().retain(other._mesh);
+		}
+		if (_mesh) {
+			getMeshRegistry().release(_mesh);
+		}
+
+		_mesh = other._mesh;
+
+		return *this;
+	}
+
+#pragma endregion
+
+
+#pragma region funções getters da classe MeshRegistry
+
+	int MeshRegistry::getNumberOfMeshes() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return (int)_meshes.size();
+	}
+
+	int MeshRegistry::getNumberOfRequests() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _numberOfRequests;
+	}
+
+	int MeshRegistry::getNumberOfCacheHits() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _numberOfCacheHits;
+	}
+
+#pragma endregion
+
+
+#pragma region construtor da classe MeshRegistry
+
+	MeshRegistry::MeshRegistry() {
+		_numberOfRequests = 0;
+		_numberOfCacheHits = 0;
+	}
+
+#pragma endregion
+
+
+#pragma region funções principais da classe MeshRegistry
+
+	MeshHandle MeshRegistry::acquire(const char* objFilepath, std::string* mtlFilename) {
+		std::string cacheFilepath = std::string(objFilepath) + MESH_CACHE_EXTENSION;
+		unsigned long long hash;
+
+		// se existe uma cache válida, o hash e o material vêm do cabeçalho e o .obj não é lido
+		MappedFile* cacheFile = new MappedFile;
+		const MeshCacheHeader* header = openMeshCache(cacheFilepath.c_str(), objFilepath, cacheFile);
+
+		if (header) {
+			hash = header->geometryHash;
+			*mtlFilename = header->materialFilename;
+		}
+		else {
+			delete cacheFile;
+			cacheFile = nullptr;
+
+			// o hash só lê as linhas de geometria, o que é muito mais barato do que interpretar o ficheiro
+			hash = hashObjGeometry(objFilepath, mtlFilename);
+
+			// se houve erros ao abrir o ficheiro
+			if (hash == 0) {
+				std::cerr << "Erro ao abrir o ficheiro '" << objFilepath << "'." << std::endl;
+				return MeshHandle();
+			}
+		}
+
+		Mesh* mesh;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_numberOfRequests++;
+			if (cacheFile) {
+				_numberOfCacheHits++;
+			}
+
+			auto found = _meshes.find(hash);
+			if (found != _meshes.end()) {
+				mesh = found->second;
+			}
+			else {
+				mesh = new Mesh;
+				mesh->hash = hash;
+				mesh->vertices = nullptr;
+				mesh->indices = nullptr;
+				mesh->numberOfVertices = 0;
+				mesh->numberOfIndices = 0;
+				mesh->indexType = GL_UNSIGNED_INT;
+				mesh->bounds = { glm::vec3(0.0f), 0.0f };
+				mesh->arena = nullptr;
+				mesh->cacheFile = nullptr;
+				mesh->vao = 0;
+				mesh->vbo = 0;
+				mesh->ebo = 0;
+				mesh->isSent = false;
+				mesh->references = 0;
+				_meshes[hash] = mesh;
+			}
+
+			// a referência é contada já, para a malha não ser removida enquanto é lida
+			mesh->references++;
+		}
+
+		// só a primeira thread carrega a malha; as outras com a mesma geometria esperam que termine
+		std::call_once(mesh->loaded, [mesh, objFilepath, &cacheFile, header]() {
+			// a partir da cache: os dados ficam no ficheiro mapeado, sem cópias
+			if (cacheFile) {
+				mesh->vertices = (const float*)(cacheFile->getData() + header->vertexOffset);
+				mesh->indices = cacheFile->getData() + header->indexOffset;
+				mesh->numberOfVertices = (int)header->numberOfVertices;
+				mesh->numberOfIndices = (int)header->numberOfIndices;
+				mesh->indexType = (GLenum)header->indexType;
+				mesh->cacheFile = cacheFile;
+				mesh->bounds = computeBoundingSphere(mesh->vertices, mesh->numberOfVertices, MESH_VERTEX_SIZE);
+				trackCpuMemory(MEMORY_MESHES, getStagingBytes(mesh));
+				cacheFile = nullptr;
+				return;
+			}
+
+			// a partir do .obj: todos os arrays da leitura ficam na arena, libertada de uma vez depois do envio
+			Arena* arena = new Arena;
+
+			if (!loadObjMesh(objFilepath, arena, mesh)) {
+				delete arena;
+				return;
+			}
+
+			mesh->arena = arena;
+			mesh->bounds = computeBoundingSphere(mesh->vertices, mesh->numberOfVertices, MESH_VERTEX_SIZE);
+			trackCpuMemory(MEMORY_MESHES, getStagingBytes(mesh));
+		});
+
+		// se a cache deste ficheiro não foi usada (outra bola já tinha carregado a mesma malha)
+		delete cacheFile;
+
+		// se a leitura falhou, a malha sai do registo (o call_once já não volta a correr para ela),
+		// para que um pedido seguinte crie uma malha nova e tente ler o ficheiro outra vez
+		if (!mesh->vertices && !mesh->isSent) {
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				auto found = _meshes.find(hash);
+				if (found != _meshes.end() && found->second == mesh) {
+					_meshes.erase(found);
+				}
+			}
+
+			release(mesh);
+			return MeshHandle();
+		}
+
+		// se o .obj foi lido, guarda a cache deste ficheiro para os próximos arranques
+		if (!header && mesh->vertices) {
+			writeMeshCache(cacheFilepath.c_str(), objFilepath, mesh, *mtlFilename);
+		}
+
+		MeshHandle handle(mesh);
+		release(mesh);
+
+		return handle;
+	}
+
+	void MeshRegistry::send(const MeshHandle& handle) {
+		Mesh* mesh = handle.getMesh();
+
+		// se a malha já foi enviada para a GPU por outro objeto
+		if (!mesh || mesh->isSent || !mesh->vertices) {
+			return;
+		}
+
+		size_t indexSize = mesh->indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+		size_t vertexBytes = (size_t)mesh->numberOfVertices * MESH_VERTEX_SIZE * sizeof(float);
+		size_t indexBytes = (size_t)mesh->numberOfIndices * indexSize;
+
+		// gera o nome para o VAO da malha
+		glGenVertexArrays(1, &mesh->vao);
+
+		// vincula o VAO da malha ao contexto OpenGL atual
+		glBindVertexArray(mesh->vao);
+
+		// gera o nome para o VBO da malha
+		glGenBuffers(1, &mesh->vbo);
+
+		// vincula o VBO ao contexto OpenGL atual
+		glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+
+		// inicializa o VBO atualmente ativo com dados imutáveis (diretamente do ficheiro mapeado, se veio da cache)
+		glBufferStorage(GL_ARRAY_BUFFER, vertexBytes, mesh->vertices, 0);
+
+		// gera o nome para o EBO da malha e envia os índices (o EBO fica associado ao VAO vinculado)
+		glGenBuffers(1, &mesh->ebo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ebo);
+		glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, indexBytes, mesh->indices, 0);
+
+		// ativa os atributos dos vértices (posição, normal e coordenadas de textura)
+		for (int i = 0; i < MESH_VERTEX_ATTRIBUTES; i++) {
+			const MeshAttribute& attribute = VERTEX_LAYOUT[i];
+			glVertexAttribPointer(attribute.location, attribute.components, GL_FLOAT, GL_FALSE, MESH_VERTEX_SIZE * sizeof(GLfloat), (void*)(attribute.offset * sizeof(GLfloat)));
+			glEnableVertexAttribArray(attribute.location);
+		}
+
+		// desvincula o VAO atual
+		glBindVertexArray(0);
+
+		mesh->isSent = true;
+		trackGpuMemory(MEMORY_MESHES, (long long)(vertexBytes + indexBytes));
+
+		// glBufferStorage já copiou os dados, por isso a cópia da CPU deixa de ser precisa
+		// (as bolas são todas lidas antes de serem enviadas, por isso nenhuma thread está a ler estes dados)
+		releaseStaging(mesh);
+	}
+
+#pragma endregion
+
+
+#pragma region funções secundárias da classe MeshRegistry
+
+	void MeshRegistry::retain(Mesh* mesh) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		mesh->references++;
+	}
+
+	void MeshRegistry::release(Mesh* mesh) {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			// se ainda há objetos a usar a malha
+			if (--mesh->references > 0) {
+				return;
+			}
+
+			// só remove a entrada se ainda é desta malha (uma malha cuja leitura falhou já foi substituída)
+			auto found = _meshes.find(mesh->hash);
+			if (found != _meshes.end() && found->second == mesh) {
+				_meshes.erase(found);
+			}
+		}
+
+		// os buffers só podem ser apagados enquanto existir um contexto OpenGL
+		if (mesh->isSent && glfwGetCurrentContext()) {
+			size_t indexSize = mesh->indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+			trackGpuMemory(MEMORY_MESHES, -(long long)((size_t)mesh->numberOfVertices * MESH_VERTEX_SIZE * sizeof(float) + (size_t)mesh->numberOfIndices * indexSize));
+
+			glDeleteBuffers(1, &mesh->vbo);
+			glDeleteBuffers(1, &mesh->ebo);
+			glDeleteVertexArrays(1, &mesh->vao);
+		}
+
+		// se a malha nunca foi enviada, os dados da CPU ainda existem
+		releaseStaging(mesh);
+		delete mesh;
+	}
+
+#pragma endregion
+
+
+#pragma region funções globais do registo de malhas
+
+	MeshRegistry& getMeshRegistry(void) {
+		// criado na primeira utilização e nunca destruído, para continuar válido quando os objetos globais
+		// que guardam handles (como as bolas) forem destruídos no fim do programa
+		static MeshRegistry* registry = new MeshRegistry;
+		return *registry;
+	}
+
+	unsigned long long hashObjGeometry(const char* objFilepath, std::string* mtlFilename) {
+		MappedFile file;
+
+		// se houve erros ao abrir o ficheiro
+		if (!file.open(objFilepath)) {
+			return 0;
+		}
+
+		const char* p = (const char*)file.getData();
+		const char* end = p + file.getSize();
+
+		// hash FNV-1a das linhas de vértices (v, vt, vn) e faces (f), ignorando materiais, grupos e comentários
+		unsigned long long hash = FNV_OFFSET_BASIS;
+
+		while (p < end) {
+			const char* lineEnd = p;
+			while (lineEnd < end && *lineEnd != '\n') {
+				lineEnd++;
+			}
+
+			// o '\r' das linhas terminadas em "\r\n" não conta, para o hash não depender do fim de linha
+			const char* contentEnd = lineEnd > p && lineEnd[-1] == '\r' ? lineEnd - 1 : lineEnd;
+
+			// o material é guardado à parte, para não ser preciso ler o ficheiro outra vez
+			if (contentEnd - p >= 7 && std::memcmp(p, "mtllib ", 7) == 0) {
+				const char* token;
+				size_t length;
+				parseToken(p + 7, contentEnd, &token, &length);
+				mtlFilename->assign(token, length);
+			}
+			else if (contentEnd > p && (*p == 'v' || *p == 'f')) {
+				for (const char* c = p; c < contentEnd; c++) {
+					hash = (hash ^ (unsigned char)*c) * FNV_PRIME;
+				}
+				hash = (hash ^ '\n') * FNV_PRIME;
+			}
+
+			p = lineEnd < end ? lineEnd + 1 : end;
+		}
+
+		return hash;
+	}
+
+	bool loadObjMesh(const char* objFilepath, Arena* arena, Mesh* mesh) {
+		MappedFile file;
+
+		// se houve erros ao abrir o ficheiro
+		if (!file.open(objFilepath)) {
+			std::cerr << "Erro ao abrir o ficheiro '" << objFilepath << "'." << std::endl;
+			return false;
+		}
+
+		const char* begin = (const char*)file.getData();
+		const char* end = begin + file.getSize();
+
+		// primeira passagem: conta os atributos e os cantos das faces, para reservar tudo de uma vez
+		size_t numberOfPositions = 0, numberOfTexcoords = 0, numberOfNormals = 0;
+		size_t numberOfCorners = 0, numberOfTriangles = 0;
+
+		for (const char* p = begin; p < end; p = skipLine(p, end)) {
+			p = skipSpaces(p, end);
+
+			if (matchKeyword(p, end, "v")) {
+				numberOfPositions++;
+			}
+			else if (matchKeyword(p, end, "vt")) {
+				numberOfTexcoords++;
+			}
+			else if (matchKeyword(p, end, "vn")) {
+				numberOfNormals++;
+			}
+			else if (matchKeyword(p, end, "f")) {
+				const char* token;
+				size_t length;
+				size_t corners = 0;
+
+				for (p = parseToken(p + 1, end, &token, &length); length > 0; p = parseToken(p, end, &token, &length)) {
+					corners++;
+				}
+
+				// cada face com n cantos dá n - 2 triângulos (em leque a partir do primeiro canto)
+				numberOfCorners += corners;
+				numberOfTriangles += corners >= 3 ? corners - 2 : 0;
+			}
+		}
+
+		// se o ficheiro não tem triângulos
+		if (numberOfTriangles == 0) {
+			std::cerr << "O ficheiro '" << objFilepath << "' nao tem faces." << std::endl;
+			return false;
+		}
+
+		// tabela da soldadura com endereçamento aberto, pelo menos com o dobro das posições necessárias
+		size_t tableSize = 1;
+		while (tableSize < 2 * numberOfCorners) {
+			tableSize <<= 1;
+		}
+
+		// os vértices únicos nunca são mais do que os cantos e os índices de 16 bits são escritos por cima dos de 32
+		arena->reserve((3 * numberOfPositions + 2 * numberOfTexcoords + 3 * numberOfNormals + MESH_VERTEX_SIZE * numberOfCorners) * sizeof(float)
+			+ (3 * numberOfTriangles + tableSize) * sizeof(unsigned int) + 6 * ARENA_ALIGNMENT);
+
+		float* positions = arena->allocateArray<float>(3 * numberOfPositions);
+		float* texcoords = arena->allocateArray<float>(2 * numberOfTexcoords);
+		float* normals = arena->allocateArray<float>(3 * numberOfNormals);
+		float* vertices = arena->allocateArray<float>(MESH_VERTEX_SIZE * numberOfCorners);
+		unsigned int* indices = arena->allocateArray<unsigned int>(3 * numberOfTriangles);
+		unsigned int* table = arena->allocateArray<unsigned int>(tableSize);
+		std::memset(table, 0xFF, tableSize * sizeof(unsigned int));
+
+		// segunda passagem: lê os atributos e solda os vértices de faces diferentes com os mesmos atributos
+		size_t positionCount = 0, texcoordCount = 0, normalCount = 0;
+		unsigned int numberOfVertices = 0;
+		size_t numberOfIndices = 0;
+		int lineNumber = 1;
+
+		for (const char* p = begin; p < end; p = skipLine(p, end), lineNumber++) {
+			p = skipSpaces(p, end);
+
+			if (matchKeyword(p, end, "v")) {
+				float* position = positions + 3 * positionCount++;
+				p = parseFloat(p + 1, end, &position[0]);
+				p = parseFloat(p, end, &position[1]);
+				p = parseFloat(p, end, &position[2]);
+				continue;
+			}
+			if (matchKeyword(p, end, "vt")) {
+				float* texcoord = texcoords + 2 * texcoordCount++;
+				p = parseFloat(p + 2, end, &texcoord[0]);
+				p = parseFloat(p, end, &texcoord[1]);
+				continue;
+			}
+			if (matchKeyword(p, end, "vn")) {
+				float* normal = normals + 3 * normalCount++;
+				p = parseFloat(p + 2, end, &normal[0]);
+				p = parseFloat(p, end, &normal[1]);
+				p = parseFloat(p, end, &normal[2]);
+				continue;
+			}
+			if (!matchKeyword(p, end, "f")) {
+				continue;
+			}
+
+			unsigned int first = 0, previous = 0;
+			int corner = 0;
+
+			for (p = skipSpaces(p + 1, end); p < end && *p != '\r' && *p != '\n'; p = skipSpaces(p, end), corner++) {
+				// canto no formato v, v/vt, v//vn ou v/vt/vn (índices a partir de 1, ou negativos a contar do fim)
+				int positionIndex = 0, texcoordIndex = 0, normalIndex = 0;
+				const char* next = parseInt(p, end, &positionIndex);
+				bool isValid = next != p;
+
+				if (isValid && next < end && *next == '/') {
+					next++;
+					if (next < end && *next != '/') {
+						const char* start = next;
+						next = parseInt(next, end, &texcoordIndex);
+						isValid = next != start;
+					}
+					if (isValid && next < end && *next == '/') {
+						const char* start = ++next;
+						next = parseInt(next, end, &normalIndex);
+						isValid = next != start;
+					}
+				}
+
+				long long position = positionIndex < 0 ? (long long)positionCount + positionIndex : (long long)positionIndex - 1;
+				long long texcoord = texcoordIndex < 0 ? (long long)texcoordCount + texcoordIndex : (long long)texcoordIndex - 1;
+				long long normal = normalIndex < 0 ? (long long)normalCount + normalIndex : (long long)normalIndex - 1;
+
+				// se o canto está mal formado ou referencia atributos que não existem
+				if (!isValid || (next < end && *next != ' ' && *next != '\t' && *next != '\r' && *next != '\n')
+					|| position < 0 || position >= (long long)positionCount
+					|| (texcoordIndex != 0 && (texcoord < 0 || texcoord >= (long long)texcoordCount))
+					|| (normalIndex != 0 && (normal < 0 || normal >= (long long)normalCount))) {
+					std::cerr << "Face invalida no ficheiro '" << objFilepath << "' (linha " << lineNumber << ")." << std::endl;
+					return false;
+				}
+				p = next;
+
+				// atributos em falta ficam a zero
+				WeldKey key = { { 0.0f } };
+				std::memcpy(key.data, positions + 3 * position, 3 * sizeof(float));
+				if (normalIndex != 0) {
+					std::memcpy(key.data + 3, normals + 3 * normal, 3 * sizeof(float));
+				}
+				if (texcoordIndex != 0) {
+					std::memcpy(key.data + 6, texcoords + 2 * texcoord, 2 * sizeof(float));
+				}
+
+				// procura o vértice na tabela; se ainda não existe, é acrescentado
+				size_t slot = hashWeldKey(key) & (tableSize - 1);
+				while (table[slot] != WELD_EMPTY && !(*(const WeldKey*)(vertices + (size_t)table[slot] * MESH_VERTEX_SIZE) == key)) {
+					slot = (slot + 1) & (tableSize - 1);
+				}
+				if (table[slot] == WELD_EMPTY) {
+					table[slot] = numberOfVertices;
+					std::memcpy(vertices + (size_t)numberOfVertices * MESH_VERTEX_SIZE, key.data, sizeof(key.data));
+					numberOfVertices++;
+				}
+
+				unsigned int index = table[slot];
+
+				// triangulação em leque: (primeiro, anterior, atual)
+				if (corner == 0) {
+					first = index;
+				}
+				else if (corner >= 2) {
+					indices[numberOfIndices++] = first;
+					indices[numberOfIndices++] = previous;
+					indices[numberOfIndices++] = index;
+				}
+				previous = index;
+			}
+		}
+
+		mesh->vertices = vertices;
+		mesh->indices = indices;
+		mesh->numberOfVertices = (int)numberOfVertices;
+		mesh->numberOfIndices = (int)numberOfIndices;
+
+		// índices de 16 bits sempre que os vértices únicos cabem neles (metade da memória), escritos no mesmo array
+		mesh->indexType = numberOfVertices <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+		if (mesh->indexType == GL_UNSIGNED_SHORT) {
+			// (por memcpy, porque os dois arrays ocupam a mesma memória; cada índice é lido antes de ser tapado)
+			unsigned char* bytes = (unsigned char*)indices;
+			for (size_t i = 0; i < numberOfIndices; i++) {
+				unsigned int index;
+				std::memcpy(&index, bytes + i * sizeof(unsigned int), sizeof(index));
+				unsigned short shortIndex = (unsigned short)index;
+				std::memcpy(bytes + i * sizeof(unsigned short), &shortIndex, sizeof(shortIndex));
+			}
+		}
+
+		return true;
+	}
+
+	const MeshCacheHeader* openMeshCache(const char* cacheFilepath, const char* objFilepath, MappedFile* file) {
+		long long sourceSize, sourceTime;
+
+		// se o .obj ou a cache não existem
+		if (!getFileInfo(objFilepath, &sourceSize, &sourceTime) || !file->open(cacheFilepath)) {
+			return nullptr;
+		}
+
+		const MeshCacheHeader* header = (const MeshCacheHeader*)file->getData();
+		size_t fileSize = file->getSize();
+		bool isValid = fileSize >= sizeof(MeshCacheHeader)
+			&& header->magic == MESH_CACHE_MAGIC
+			&& header->version == MESH_CACHE_VERSION
+			&& header->sourceSize == sourceSize
+			&& header->sourceTime == sourceTime
+			&& header->vertexSize == MESH_VERTEX_SIZE
+			&& header->numberOfAttributes == MESH_VERTEX_ATTRIBUTES
+			&& std::memcmp(header->attributes, VERTEX_LAYOUT, sizeof(VERTEX_LAYOUT)) == 0
+			&& (header->indexType == GL_UNSIGNED_SHORT || header->indexType == GL_UNSIGNED_INT)
+			&& std::memchr(header->materialFilename, '\0', MESH_MATERIAL_NAME_SIZE) != nullptr;
+
+		// confirma que os blocos de vértices e índices cabem no ficheiro (cache truncada)
+		if (isValid) {
+			unsigned long long vertexBytes = (unsigned long long)header->numberOfVertices * MESH_VERTEX_SIZE * sizeof(float);
+			unsigned long long indexBytes = (unsigned long long)header->numberOfIndices * (header->indexType == GL_UNSIGNED_SHORT ? 2 : 4);
+			isValid = header->vertexOffset + vertexBytes <= fileSize && header->indexOffset + indexBytes <= fileSize;
+		}
+
+		// se a cache é de outra versão ou o .obj foi alterado depois de a cache ser criada
+		if (!isValid) {
+			file->close();
+			return nullptr;
+		}
+
+		return header;
+	}
+
+	bool writeMeshCache(const char* cacheFilepath, const char* objFilepath, const Mesh* mesh, const std::string& mtlFilename) {
+		MeshCacheHeader header;
+		std::memset(&header, 0, sizeof(header));
+
+		// se não é possível guardar a origem ou o nome do material
+		if (!getFileInfo(objFilepath, &header.sourceSize, &header.sourceTime) || mtlFilename.size() >= MESH_MATERIAL_NAME_SIZE) {
+			return false;
+		}
+
+		size_t vertexBytes = (size_t)mesh->numberOfVertices * MESH_VERTEX_SIZE * sizeof(float);
+		size_t indexBytes = (size_t)mesh->numberOfIndices * (mesh->indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int));
+
+		header.magic = MESH_CACHE_MAGIC;
+		header.version = MESH_CACHE_VERSION;
+		header.geometryHash = mesh->hash;
+		header.vertexSize = MESH_VERTEX_SIZE;
+		header.numberOfAttributes = MESH_VERTEX_ATTRIBUTES;
+		std::memcpy(header.attributes, VERTEX_LAYOUT, sizeof(VERTEX_LAYOUT));
+		header.numberOfVertices = (unsigned int)mesh->numberOfVertices;
+		header.numberOfIndices = (unsigned int)mesh->numberOfIndices;
+		header.indexType = mesh->indexType;
+		header.vertexOffset = sizeof(MeshCacheHeader);
+		header.indexOffset = header.vertexOffset + vertexBytes;
+		std::memcpy(header.materialFilename, mtlFilename.c_str(), mtlFilename.size() + 1);
+
+		std::ofstream file(cacheFilepath, std::ios::binary | std::ios::trunc);
+
+		// se não foi possível criar o ficheiro (por exemplo, pasta só de leitura), a cache não é usada
+		if (!file) {
+			return false;
+		}
+
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)mesh->vertices, vertexBytes);
+		file.write((const char*)mesh->indices, indexBytes);
+
+		return (bool)file;
+	}
+
+#pragma endregion
+
+}
@@ -0,0 +1,155 @@
+/*
+ * @descrição	Ficheiro com todas as assinaturas relativas ao registo de malhas partilhadas.
+ * @ficheiro	Mesh.h
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+*/
+
+
+#pragma once
+
+#ifndef MESH_H
+#define MESH_H 1
+
+#pragma region importações
+
+#include <string>
+#include <mutex>
+#include <unordered_map>
+
+#define GLEW_STATIC
+#include <GL\glew.h>
+
+#include "Arena.h"
+#include "MappedFile.h"
+#include "Culling.h"
+
+#pragma endregion
+
+
+#pragma region constantes
+
+#define MESH_VERTEX_SIZE 8				// floats por vértice (posição, normal e coordenadas de textura)
+#define MESH_VERTEX_ATTRIBUTES 3		// atributos por vértice
+#define MESH_MAX_ATTRIBUTES 4			// atributos que cabem no descritor do ficheiro de cache
+#define MESH_MATERIAL_NAME_SIZE 256		// tamanho máximo do nome do ficheiro .mtl na cache
+#define MESH_CACHE_EXTENSION ".mesh"	// extensão do ficheiro de cache, acrescentada ao nome do .obj
+#define MESH_CACHE_MAGIC 0x434D4250		// "PBMC"
+#define MESH_CACHE_VERSION 1
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region declarações do registo de malhas
+
+	// estrutura de um atributo de vértice (descritor da disposição dos vértices)
+	typedef struct {
+		unsigned int location;		// localização do atributo no shader
+		unsigned int components;	// número de floats do atributo
+		unsigned int offset;		// posição do primeiro float dentro do vértice
+	} MeshAttribute;
+
+	// estrutura do cabeçalho do ficheiro binário de cache de uma malha (seguido dos vértices e dos índices)
+	typedef struct {
+		unsigned int magic;							// MESH_CACHE_MAGIC
+		unsigned int version;						// MESH_CACHE_VERSION
+		long long sourceSize;						// tamanho do .obj de origem quando a cache foi criada
+		long long sourceTime;						// data de modificação do .obj de origem
+		unsigned long long geometryHash;			// hash do conteúdo geométrico do .obj
+		unsigned int vertexSize;					// floats por vértice
+		unsigned int numberOfAttributes;
+		MeshAttribute attributes[MESH_MAX_ATTRIBUTES];
+		unsigned int numberOfVertices;
+		unsigned int numberOfIndices;
+		unsigned int indexType;						// GL_UNSIGNED_SHORT ou GL_UNSIGNED_INT
+		unsigned int reserved;
+		unsigned long long vertexOffset;			// posição dos vértices no ficheiro
+		unsigned long long indexOffset;				// posição dos índices no ficheiro
+		char materialFilename[MESH_MATERIAL_NAME_SIZE];	// ficheiro .mtl referenciado pelo .obj
+	} MeshCacheHeader;
+
+	// estrutura de uma malha carregada uma única vez e partilhada por todos os objetos com a mesma geometria
+	typedef struct {
+		unsigned long long hash;		// hash do conteúdo geométrico do ficheiro .obj
+		const float* vertices;			// vértices únicos (na arena ou no ficheiro de cache mapeado; nulo depois do envio)
+		const void* indices;			// índices dos vértices de cada triângulo, com o tamanho de indexType
+		int numberOfVertices;
+		int numberOfIndices;
+		GLenum indexType;				// GL_UNSIGNED_SHORT ou GL_UNSIGNED_INT, consoante o número de vértices
+		BoundingSphere bounds;			// esfera envolvente no espaço do objeto, calculada ao carregar
+		Arena* arena;					// memória da leitura do .obj, com os vértices e índices (nulo se vieram da cache)
+		MappedFile* cacheFile;			// ficheiro de cache mapeado (nulo se a malha foi interpretada do .obj)
+		GLuint vao;
+		GLuint vbo;
+		GLuint ebo;
+		bool isSent;					// se os dados já foram enviados para a GPU
+		int references;					// número de handles que apontam para a malha
+		std::once_flag loaded;			// garante que o ficheiro é lido uma só vez, mesmo com várias threads
+	} Mesh;
+
+	// classe de um handle para uma malha do registo (conta as referências ao ser copiado ou destruído)
+	class MeshHandle {
+	private:
+		// atributos privados
+		Mesh* _mesh;
+
+	public:
+		// getters - obter valores de atributos fora da classe
+		Mesh* getMesh() const;
+		bool isValid() const;
+
+		// construtores
+		MeshHandle();
+		MeshHandle(Mesh* mesh);
+		MeshHandle(const MeshHandle& other);
+
+		// destrutor
+		~MeshHandle();
+
+		// operadores
+		MeshHandle& operator=(const MeshHandle& other);
+	};
+
+	// classe do registo de malhas, indexado pelo hash do conteúdo geométrico
+	class MeshRegistry {
+	private:
+		// atributos privados
+		std::unordered_map<unsigned long long, Mesh*> _meshes;
+		std::mutex _mutex;
+		int _numberOfRequests;		// pedidos de malhas (inclui os que reutilizaram uma malha já carregada)
+		int _numberOfCacheHits;		// pedidos servidos pelo ficheiro de cache, sem ler o .obj
+
+		friend class MeshHandle;
+
+		// secundárias
+		void retain(Mesh* mesh);
+		void release(Mesh* mesh);
+
+	public:
+		// getters - obter valores de atributos fora da classe
+		int getNumberOfMeshes();
+		int getNumberOfRequests();
+		int getNumberOfCacheHits();
+
+		// construtor
+		MeshRegistry();
+
+		// principais
+		MeshHandle acquire(const char* objFilepath, std::string* mtlFilename);
+		void send(const MeshHandle& handle);
+	};
+
+	// funções globais do registo de malhas
+	MeshRegistry& getMeshRegistry(void);
+	unsigned long long hashObjGeometry(const char* objFilepath, std::string* mtlFilename);
+	bool loadObjMesh(const char* objFilepath, Arena* arena, Mesh* mesh);
+	const MeshCacheHeader* openMeshCache(const char* cacheFilepath, const char* objFilepath, MappedFile* file);
+	bool writeMeshCache(const char* cacheFilepath, const char* objFilepath, const Mesh* mesh, const std::string& mtlFilename);
+
+#pragma endregion
+
+}
+
+#endif
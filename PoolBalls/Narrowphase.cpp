@@ -0,0 +1,203 @@
+﻿/*
+ * @descrição	Ficheiro com todo o código relativo aos kernels de teste de contacto entre bolas.
+ * @ficheiro	Narrowphase.cpp
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+ *
+ * -------------------------------------
+ *
+ * Os kernels testam vários pares por instrução a partir das posições guardadas em arrays separados (x[], y[], z[]):
+ * 8 pares com AVX2 (com gather), 4 pares com SSE e 1 par na versão escalar. O kernel é escolhido uma única vez,
+ * em tempo de execução, conforme o processador. Todos fazem as mesmas operações pela mesma ordem,
+ * por isso o resultado é igual em qualquer máquina.
+*/
+
+
+#pragma region importações
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <immintrin.h>
+
+#include "Narrowphase.h"
+
+#pragma endregion
+
+
+#pragma region constantes
+
+// o gcc/clang só geram instruções AVX2 em funções marcadas explicitamente
+#if defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region funções auxiliares
+
+	static bool isSse2Supported(void) {
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		return (info[3] & (1 << 26)) != 0;
+#elif defined(__GNUC__)
+		return __builtin_cpu_supports("sse2");
+#else
+		return false;
+#endif
+	}
+
+	static bool isAvx2Supported(void) {
+#if defined(_MSC_VER)
+		int info[4];
+
+		// se o processador não tem a folha 7 do cpuid
+		__cpuid(info, 0);
+		if (info[0] < 7) {
+			return false;
+		}
+
+		// se o processador não tem AVX ou o sistema operativo não guarda os registos YMM
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+			return false;
+		}
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__)
+		return __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif
+	}
+
+#pragma endregion
+
+
+#pragma region kernels da narrowphase
+
+	int findTouchingPairsScalar(const float* x, const float* y, const float* z, const int* ballA, const int* ballB, int count, float minDistanceSquared, int* hits) {
+		int numberOfHits = 0;
+
+		for (int i = 0; i < count; i++) {
+			float dx = x[ballB[i]] - x[ballA[i]];
+			float dy = y[ballB[i]] - y[ballA[i]];
+			float dz = z[ballB[i]] - z[ballA[i]];
+
+			if (dx * dx + dy * dy + dz * dz <= minDistanceSquared) {
+				hits[numberOfHits++] = i;
+			}
+		}
+
+		return numberOfHits;
+	}
+
+	int findTouchingPairsSse(const float* x, const float* y, const float* z, const int* ballA, const int* ballB, int count, float minDistanceSquared, int* hits) {
+		__m128 limit = _mm_set1_ps(minDistanceSquared);
+		int numberOfHits = 0;
+		int i = 0;
+
+		// 4 pares de cada vez (sem gather, as posições são carregadas uma a uma)
+		for (; i + 4 <= count; i += 4) {
+			const int* a = ballA + i;
+			const int* b = ballB + i;
+
+			__m128 dx = _mm_sub_ps(_mm_set_ps(x[b[3]], x[b[2]], x[b[1]], x[b[0]]), _mm_set_ps(x[a[3]], x[a[2]], x[a[1]], x[a[0]]));
+			__m128 dy = _mm_sub_ps(_mm_set_ps(y[b[3]], y[b[2]], y[b[1]], y[b[0]]), _mm_set_ps(y[a[3]], y[a[2]], y[a[1]], y[a[0]]));
+			__m128 dz = _mm_sub_ps(_mm_set_ps(z[b[3]], z[b[2]], z[b[1]], z[b[0]]), _mm_set_ps(z[a[3]], z[a[2]], z[a[1]], z[a[0]]));
+			__m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+			int mask = _mm_movemask_ps(_mm_cmple_ps(distanceSquared, limit));
+			for (int k = 0; mask != 0; k++, mask >>= 1) {
+				if (mask & 1) {
+					hits[numberOfHits++] = i + k;
+				}
+			}
+		}
+
+		// pares que sobram
+		int tailHits = findTouchingPairsScalar(x, y, z, ballA + i, ballB + i, count - i, minDistanceSquared, hits + numberOfHits);
+		for (int k = 0; k < tailHits; k++) {
+			hits[numberOfHits + k] += i;
+		}
+
+		return numberOfHits + tailHits;
+	}
+
+	TARGET_AVX2 int findTouchingPairsAvx2(const float* x, const float* y, const float* z, const int* ballA, const int* ballB, int count, float minDistanceSquared, int* hits) {
+		__m256 limit = _mm256_set1_ps(minDistanceSquared);
+		int numberOfHits = 0;
+		int i = 0;
+
+		// 8 pares de cada vez, com as posições recolhidas por gather
+		for (; i + 8 <= count; i += 8) {
+			__m256i a = _mm256_loadu_si256((const __m256i*)(ballA + i));
+			__m256i b = _mm256_loadu_si256((const __m256i*)(ballB + i));
+
+			__m256 dx = _mm256_sub_ps(_mm256_i32gather_ps(x, b, 4), _mm256_i32gather_ps(x, a, 4));
+			__m256 dy = _mm256_sub_ps(_mm256_i32gather_ps(y, b, 4), _mm256_i32gather_ps(y, a, 4));
+			__m256 dz = _mm256_sub_ps(_mm256_i32gather_ps(z, b, 4), _mm256_i32gather_ps(z, a, 4));
+			__m256 distanceSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+
+			int mask = _mm256_movemask_ps(_mm256_cmp_ps(distanceSquared, limit, _CMP_LE_OQ));
+			for (int k = 0; mask != 0; k++, mask >>= 1) {
+				if (mask & 1) {
+					hits[numberOfHits++] = i + k;
+				}
+			}
+		}
+
+		// pares que sobram
+		int tailHits = findTouchingPairsSse(x, y, z, ballA + i, ballB + i, count - i, minDistanceSquared, hits + numberOfHits);
+		for (int k = 0; k < tailHits; k++) {
+			hits[numberOfHits + k] += i;
+		}
+
+		return numberOfHits + tailHits;
+	}
+
+#pragma endregion
+
+
+#pragma region funções globais da narrowphase
+
+	NarrowphaseKernel getNarrowphaseKernel(void) {
+		// escolhido uma única vez, na primeira chamada
+		static const NarrowphaseKernel kernel =
+			isAvx2Supported() ? findTouchingPairsAvx2 :
+			isSse2Supported() ? findTouchingPairsSse :
+			findTouchingPairsScalar;
+
+		return kernel;
+	}
+
+	const char* getNarrowphaseKernelName(void) {
+		NarrowphaseKernel kernel = getNarrowphaseKernel();
+
+		if (kernel == findTouchingPairsAvx2) {
+			return "AVX2";
+		}
+		else if (kernel == findTouchingPairsSse) {
+			return "SSE";
+		}
+
+		return "escalar";
+	}
+
+	int findTouchingPairs(const float* x, const float* y, const float* z, const int* ballA, const int* ballB, int count, float minDistanceSquared, int* hits) {
+		return getNarrowphaseKernel()(x, y, z, ballA, ballB, count, minDistanceSquared, hits);
+	}
+
+#pragma endregion
+
+}
@@ -0,0 +1,40 @@
+/*
+ * @descrição	Ficheiro com todas as assinaturas relativas aos kernels de teste de contacto entre bolas.
+ * @ficheiro	Narrowphase.h
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+*/
+
+
+#pragma once
+
+#ifndef NARROWPHASE_H
+#define NARROWPHASE_H 1
+
+namespace Pool {
+
+#pragma region declarações da narrowphase
+
+	// assinatura dos kernels de teste de contacto: recebe as posições das bolas (SoA) e os pares a testar,
+	// escreve em hits a posição de cada par cuja distância ao quadrado é <= minDistanceSquared
+	// e retorna o número de pares em contacto
+	typedef int (*NarrowphaseKernel)(
+		const float* x, const float* y, const float* z,
+		const int* ballA, const int* ballB, int count,
+		float minDistanceSquared, int* hits);
+
+	// kernels disponíveis
+	int findTouchingPairsScalar(const float* x, const float* y, const float* z, const int* ballA, const int* ballB, int count, float minDistanceSquared, int* hits);
+	int findTouchingPairsSse(const float* x, const float* y, const float* z, const int* ballA, const int* ballB, int count, float minDistanceSquared, int* hits);
+	int findTouchingPairsAvx2(const float* x, const float* y, const float* z, const int* ballA, const int* ballB, int count, float minDistanceSquared, int* hits);
+
+	// funções globais da narrowphase
+	NarrowphaseKernel getNarrowphaseKernel(void);
+	const char* getNarrowphaseKernelName(void);
+	int findTouchingPairs(const float* x, const float* y, const float* z, const int* ballA, const int* ballB, int count, float minDistanceSquared, int* hits);
+
+#pragma endregion
+
+}
+
+#endif
@@ -0,0 +1,514 @@
+﻿/*
+ * @descrição	Ficheiro com todo o código relativo à simulação física das bolas.
+ * @ficheiro	Physics.cpp
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+ *
+ * -------------------------------------
+ *
+ * A simulação avança sempre em passos de duração fixa, independentemente da taxa de frames.
+ * O tempo real de cada frame é acumulado e consumido em passos inteiros, e o estado apresentado
+ * é interpolado entre os dois últimos passos. Assim, as trajetórias são as mesmas a 30 ou a 300 fps
+ * e o custo por segundo simulado é sempre o mesmo número de passos.
+ *
+ * O estado das bolas é guardado por componente (BallStore), separado dos dados de renderização,
+ * e o teste de contacto dos pares candidatos é feito pelos kernels SIMD da narrowphase.
+ *
+ * A orientação de cada bola é um quaternião. As bolas rolam sem escorregar sobre a mesa, por isso a
+ * velocidade angular é obtida da velocidade linear (w = (cima x v) / raio), mais a rotação própria (efeito)
+ * definida com setAngularVelocity. Em cada passo, o quaternião é integrado com q += dt/2 * (0, w) * q e
+ * normalizado, num ciclo sobre os arrays de cada componente, como a posição. As bolas paradas saltam a
+ * integração, para a orientação não mudar no último bit (e a bola não ser dada como alterada) sem rodarem.
+*/
+
+
+#pragma region importações
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <glm\glm.hpp>
+#include <glm\gtc\quaternion.hpp>
+
+#include "Broadphase.h"
+#include "Jobs.h"
+#include "Narrowphase.h"
+#include "Physics.h"
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region funções getters e setters da classe Physics
+
+	// getters
+	int Physics::getNumberOfBalls() const {
+		return _balls.count;
+	}
+
+	const BallStore& Physics::getBalls() const {
+		return _balls;
+	}
+
+	glm::vec3 Physics::getPosition(int ball) const {
+		glm::vec3 previous = glm::vec3(_balls.previousX[ball], _balls.previousY[ball], _balls.previousZ[ball]);
+		glm::vec3 current = glm::vec3(_balls.x[ball], _balls.y[ball], _balls.z[ball]);
+
+		// se a bola está parada, retorna a posição exata (a interpolação pode mudar o último bit e obrigar a recalcular a matriz)
+		if (previous == current) {
+			return current;
+		}
+
+		// interpola entre o passo anterior e o atual, conforme o tempo que ficou por simular
+		return glm::mix(previous, current, (float)getInterpolation());
+	}
+
+	glm::quat Physics::getOrientation(int ball) const {
+		glm::quat previous = glm::quat(_balls.previousQw[ball], _balls.previousQx[ball], _balls.previousQy[ball], _balls.previousQz[ball]);
+		glm::quat current = glm::quat(_balls.qw[ball], _balls.qx[ball], _balls.qy[ball], _balls.qz[ball]);
+
+		// se a bola não rodou, retorna a orientação exata
+		if (previous == current) {
+			return current;
+		}
+
+		// interpolação linear normalizada (a rotação num só passo é pequena, por isso é quase igual à esférica)
+		float alpha = (float)getInterpolation();
+		return glm::normalize(previous * (1.0f - alpha) + current * alpha);
+	}
+
+	glm::vec3 Physics::getVelocity(int ball) const {
+		return glm::vec3(_balls.vx[ball], _balls.vy[ball], _balls.vz[ball]);
+	}
+
+	const std::vector<Contact>& Physics::getContacts() const {
+		return _contacts;
+	}
+
+	double Physics::getTimeStep() const {
+		return _timeStep;
+	}
+
+	double Physics::getInterpolation() const {
+		return _accumulator / _timeStep;
+	}
+
+	long long Physics::getStepCount() const {
+		return _stepCount;
+	}
+
+	bool Physics::isMoving() const {
+		for (int i = 0; i < _balls.count; i++) {
+			if (_balls.vx[i] != 0.0f || _balls.vy[i] != 0.0f || _balls.vz[i] != 0.0f ||
+				_balls.wx[i] != 0.0f || _balls.wy[i] != 0.0f || _balls.wz[i] != 0.0f) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// setters
+	void Physics::setFrequency(double frequency) {
+		_timeStep = 1.0 / frequency;
+		_accumulator = 0.0;
+	}
+
+	void Physics::setMaxSubSteps(int maxSubSteps) {
+		_maxSubSteps = maxSubSteps;
+	}
+
+	void Physics::setFriction(float friction) {
+		_friction = friction;
+	}
+
+	void Physics::setVelocity(int ball, glm::vec3 velocity) {
+		_balls.vx[ball] = velocity.x;
+		_balls.vy[ball] = velocity.y;
+		_balls.vz[ball] = velocity.z;
+	}
+
+	void Physics::setAngularVelocity(int ball, glm::vec3 angularVelocity) {
+		_balls.wx[ball] = angularVelocity.x;
+		_balls.wy[ball] = angularVelocity.y;
+		_balls.wz[ball] = angularVelocity.z;
+	}
+
+#pragma endregion
+
+
+#pragma region construtor da classe Physics
+
+	Physics::Physics(double frequency, int maxSubSteps) : _grid(2 * BALL_RADIUS) {
+		_balls.count = 0;
+		_timeStep = 1.0 / frequency;
+		_accumulator = 0.0;
+		_maxSubSteps = maxSubSteps;
+		_friction = 0.0f;
+		_stepCount = 0;
+	}
+
+#pragma endregion
+
+
+#pragma region funções principais da classe Physics
+
+	int Physics::addBall(glm::vec3 position, glm::quat orientation) {
+		_balls.x.push_back(position.x);
+		_balls.y.push_back(position.y);
+		_balls.z.push_back(position.z);
+		_balls.previousX.push_back(position.x);
+		_balls.previousY.push_back(position.y);
+		_balls.previousZ.push_back(position.z);
+		_balls.vx.push_back(0.0f);
+		_balls.vy.push_back(0.0f);
+		_balls.vz.push_back(0.0f);
+		_balls.qx.push_back(orientation.x);
+		_balls.qy.push_back(orientation.y);
+		_balls.qz.push_back(orientation.z);
+		_balls.qw.push_back(orientation.w);
+		_balls.previousQx.push_back(orientation.x);
+		_balls.previousQy.push_back(orientation.y);
+		_balls.previousQz.push_back(orientation.z);
+		_balls.previousQw.push_back(orientation.w);
+		_balls.wx.push_back(0.0f);
+		_balls.wy.push_back(0.0f);
+		_balls.wz.push_back(0.0f);
+		_isMoving.push_back(false);
+		_isCorrected.push_back(false);
+
+		// insere a bola na grelha da broadphase
+		int index = _balls.count++;
+		_grid.insert(index, position);
+
+		return index;
+	}
+
+	int Physics::update(double frameTime) {
+		_contacts.clear();
+
+		// acumula o tempo real decorrido desde a última frame
+		_accumulator += frameTime;
+
+		// consome o tempo acumulado em passos de duração fixa
+		int steps = 0;
+		while (_accumulator >= _timeStep && steps < _maxSubSteps) {
+			step((float)_timeStep);
+			_accumulator -= _timeStep;
+			steps++;
+		}
+
+		// se a frame demorou mais do que o limite de passos permite, descarta o excesso
+		// (a simulação abranda em vez de ficar cada vez mais atrasada)
+		if (_accumulator >= _timeStep) {
+			_accumulator = std::fmod(_accumulator, _timeStep);
+		}
+
+		return steps;
+	}
+
+	void Physics::simulate(double duration) {
+		_contacts.clear();
+
+		// executa os passos correspondentes à duração, sem interpolação (uso sem janela)
+		long long steps = (long long)std::ceil(duration / _timeStep);
+		for (long long i = 0; i < steps; i++) {
+			step((float)_timeStep);
+		}
+
+		_accumulator = 0.0;
+	}
+
+#pragma endregion
+
+
+#pragma region funções secundárias da classe Physics
+
+	void Physics::step(float dt) {
+		integrate(dt);
+		solveCollisions();
+		_stepCount++;
+	}
+
+	void Physics::integrate(float dt) {
+		int count = _balls.count;
+
+		// o estado atual passa a ser o anterior (troca de buffers, sem copiar), e o novo estado atual é
+		// calculado a partir dele
+		std::swap(_balls.x, _balls.previousX);
+		std::swap(_balls.y, _balls.previousY);
+		std::swap(_balls.z, _balls.previousZ);
+		std::swap(_balls.qx, _balls.previousQx);
+		std::swap(_balls.qy, _balls.previousQy);
+		std::swap(_balls.qz, _balls.previousQz);
+		std::swap(_balls.qw, _balls.previousQw);
+
+		// move e roda as bolas (ciclos simples sobre arrays contíguos, vetorizáveis pelo compilador);
+		// com muitas bolas, os blocos de PHYSICS_GRAIN_SIZE bolas são distribuídos pelo sistema de tarefas
+		float* x = _balls.x.data();
+		float* y = _balls.y.data();
+		float* z = _balls.z.data();
+		float* qx = _balls.qx.data();
+		float* qy = _balls.qy.data();
+		float* qz = _balls.qz.data();
+		float* qw = _balls.qw.data();
+		const float* px = _balls.previousX.data();
+		const float* py = _balls.previousY.data();
+		const float* pz = _balls.previousZ.data();
+		const float* pqx = _balls.previousQx.data();
+		const float* pqy = _balls.previousQy.data();
+		const float* pqz = _balls.previousQz.data();
+		const float* pqw = _balls.previousQw.data();
+		float* vx = _balls.vx.data();
+		float* vy = _balls.vy.data();
+		float* vz = _balls.vz.data();
+		float* wx = _balls.wx.data();
+		float* wy = _balls.wy.data();
+		float* wz = _balls.wz.data();
+		float friction = _friction;
+
+		auto body = [=](int from, int to) {
+			// aplica o atrito na direção contrária ao movimento
+			if (friction > 0.0f) {
+				for (int i = from; i < to; i++) {
+					float speedSquared = vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i];
+					if (speedSquared == 0.0f) {
+						continue;
+					}
+
+					float speed = std::sqrt(speedSquared);
+					float newSpeed = speed - friction * dt;
+
+					// se a bola parou
+					if (newSpeed <= 0.0f) {
+						vx[i] = vy[i] = vz[i] = 0.0f;
+						wx[i] = wy[i] = wz[i] = 0.0f;
+					}
+					else {
+						float factor = newSpeed / speed;
+						vx[i] *= factor;
+						vy[i] *= factor;
+						vz[i] *= factor;
+					}
+				}
+			}
+
+			for (int i = from; i < to; i++) {
+				x[i] = px[i] + vx[i] * dt;
+				y[i] = py[i] + vy[i] * dt;
+				z[i] = pz[i] + vz[i] * dt;
+			}
+
+			// roda as bolas: rolamento sem escorregar (w = (cima x v) / raio) mais a rotação própria
+			float halfDt = 0.5f * dt;
+			for (int i = from; i < to; i++) {
+				float ax = vz[i] / BALL_RADIUS + wx[i];
+				float ay = wy[i];
+				float az = -vx[i] / BALL_RADIUS + wz[i];
+
+				// se a bola não roda, o quaternião fica igual (sem renormalizar, para não mudar o último bit)
+				if (ax == 0.0f && ay == 0.0f && az == 0.0f) {
+					qx[i] = pqx[i];
+					qy[i] = pqy[i];
+					qz[i] = pqz[i];
+					qw[i] = pqw[i];
+					continue;
+				}
+
+				// q += dt/2 * (0, w) * q
+				float nx = pqx[i] + halfDt * (ax * pqw[i] + ay * pqz[i] - az * pqy[i]);
+				float ny = pqy[i] + halfDt * (ay * pqw[i] + az * pqx[i] - ax * pqz[i]);
+				float nz = pqz[i] + halfDt * (az * pqw[i] + ax * pqy[i] - ay * pqx[i]);
+				float nw = pqw[i] - halfDt * (ax * pqx[i] + ay * pqy[i] + az * pqz[i]);
+
+				// mantém o quaternião unitário
+				float inverseLength = 1.0f / std::sqrt(nx * nx + ny * ny + nz * nz + nw * nw);
+				qx[i] = nx * inverseLength;
+				qy[i] = ny * inverseLength;
+				qz[i] = nz * inverseLength;
+				qw[i] = nw * inverseLength;
+			}
+		};
+
+		// com poucas bolas, corre diretamente na thread atual, sem passar pelo sistema de tarefas
+		if (count <= PHYSICS_GRAIN_SIZE) {
+			body(0, count);
+		}
+		else {
+			getJobSystem().parallelFor(0, count, PHYSICS_GRAIN_SIZE, body);
+		}
+
+		// só as bolas em movimento podem iniciar um contacto
+		_movingBalls.clear();
+		for (int i = 0; i < count; i++) {
+			_isMoving[i] = vx[i] != 0.0f || vy[i] != 0.0f || vz[i] != 0.0f;
+			if (_isMoving[i]) {
+				_movingBalls.push_back(i);
+				moveBall(i);
+			}
+		}
+	}
+
+	void Physics::solveCollisions(void) {
+		// primeira passagem: pares candidatos de todas as bolas em movimento, obtidos de uma só vez
+		_grid.findPairs(_movingBalls, _isMoving, _pairs);
+		resolvePairs();
+
+		// uma correção pode criar uma sobreposição nova com uma bola vizinha; as passagens seguintes voltam a
+		// testar, já com as posições corrigidas, apenas os pares das bolas corrigidas na passagem anterior
+		for (int pass = 1; pass < PHYSICS_COLLISION_PASSES && !_correctedBalls.empty(); pass++) {
+			_grid.findPairs(_correctedBalls, _isCorrected, _pairs);
+			for (int ball : _correctedBalls) {
+				_isCorrected[ball] = false;
+			}
+			_correctedBalls.clear();
+
+			resolvePairs();
+		}
+
+		for (int ball : _correctedBalls) {
+			_isCorrected[ball] = false;
+		}
+		_correctedBalls.clear();
+
+		// colisões com as tabelas da mesa, depois das colisões entre bolas, para todas as bolas em movimento
+		// e todas as que foram empurradas ou postas em movimento por uma colisão neste passo
+		for (int ball : _movingBalls) {
+			solveCushions(ball);
+		}
+	}
+
+	void Physics::resolvePairs(void) {
+		float minDistance = 2 * BALL_RADIUS;
+
+		// testa todos os pares candidatos com o kernel SIMD
+		int numberOfPairs = (int)_pairs.ballA.size();
+		_hits.resize(numberOfPairs);
+		int numberOfHits = findTouchingPairs(
+			_balls.x.data(), _balls.y.data(), _balls.z.data(),
+			_pairs.ballA.data(), _pairs.ballB.data(), numberOfPairs,
+			minDistance * minDistance, _hits.data());
+
+		// resolve os pares em contacto, pela ordem em que foram gerados
+		for (int k = 0; k < numberOfHits; k++) {
+			int a = _pairs.ballA[_hits[k]];
+			int b = _pairs.ballB[_hits[k]];
+
+			// as posições podem ter mudado com a resolução de um par anterior
+			glm::vec3 delta = glm::vec3(_balls.x[b] - _balls.x[a], _balls.y[b] - _balls.y[a], _balls.z[b] - _balls.z[a]);
+			float distance = glm::length(delta);
+
+			// se já não se tocam
+			if (distance > minDistance || distance == 0.0f) {
+				continue;
+			}
+
+			// separa as bolas sobrepostas (e volta a testar os seus pares na passagem seguinte)
+			glm::vec3 normal = delta / distance;
+			if (distance < minDistance) {
+				glm::vec3 correction = normal * ((minDistance - distance) * 0.5f);
+				_balls.x[a] -= correction.x;
+				_balls.y[a] -= correction.y;
+				_balls.z[a] -= correction.z;
+				_balls.x[b] += correction.x;
+				_balls.y[b] += correction.y;
+				_balls.z[b] += correction.z;
+				moveBall(a);
+				moveBall(b);
+				markCorrected(a);
+				markCorrected(b);
+			}
+			markTouched(a);
+			markTouched(b);
+
+			// troca as componentes normais das velocidades (choque elástico, massas iguais)
+			glm::vec3 relativeVelocity = getVelocity(a) - getVelocity(b);
+			float approach = glm::dot(relativeVelocity, normal);
+			if (approach > 0.0f) {
+				setVelocity(a, getVelocity(a) - normal * approach);
+				setVelocity(b, getVelocity(b) + normal * approach);
+				_contacts.push_back({ a, b });
+			}
+		}
+	}
+
+	void Physics::solveCushions(int ball) {
+		float& x = _balls.x[ball];
+		float& z = _balls.z[ball];
+		float& vx = _balls.vx[ball];
+		float& vz = _balls.vz[ball];
+		float limitX = TABLE_HALF_WIDTH - BALL_RADIUS;
+		float limitZ = TABLE_HALF_DEPTH - BALL_RADIUS;
+		bool hitCushion = false;
+
+		// a bola ressalta se está na tabela e vai contra ela
+		if ((x >= limitX && vx > 0.0f) || (x <= -limitX && vx < 0.0f)) {
+			vx = -vx;
+			hitCushion = true;
+		}
+		if ((z >= limitZ && vz > 0.0f) || (z <= -limitZ && vz < 0.0f)) {
+			vz = -vz;
+			hitCushion = true;
+		}
+
+		// volta para dentro da mesa (também as bolas empurradas para fora por uma correção, mesmo sem velocidade nessa direção)
+		float clampedX = std::min(std::max(x, -limitX), limitX);
+		float clampedZ = std::min(std::max(z, -limitZ), limitZ);
+		if (clampedX != x || clampedZ != z) {
+			x = clampedX;
+			z = clampedZ;
+			moveBall(ball);
+		}
+
+		if (hitCushion) {
+			_contacts.push_back({ ball, -1 });
+		}
+	}
+
+	void Physics::markTouched(int ball) {
+		// as bolas paradas atingidas numa colisão passam a ser tratadas como em movimento até ao fim do passo
+		if (!_isMoving[ball]) {
+			_isMoving[ball] = true;
+			_movingBalls.push_back(ball);
+		}
+	}
+
+	void Physics::markCorrected(int ball) {
+		// os pares de uma bola deslocada por uma correção voltam a ser testados na passagem seguinte
+		if (!_isCorrected[ball]) {
+			_isCorrected[ball] = true;
+			_correctedBalls.push_back(ball);
+		}
+	}
+
+	void Physics::moveBall(int ball) {
+		_grid.move(ball, glm::vec3(_balls.x[ball], _balls.y[ball], _balls.z[ball]));
+	}
+
+#pragma endregion
+
+
+#pragma region funções globais da física
+
+	glm::vec3 getRollingAngularVelocity(glm::vec3 velocity) {
+		// sem escorregar, o ponto de contacto com a mesa está parado: v + w x (-raio * cima) = 0  <=>  w = (cima x v) / raio
+		return glm::vec3(velocity.z, 0.0f, -velocity.x) / BALL_RADIUS;
+	}
+
+	glm::quat rotateOrientation(glm::quat orientation, glm::vec3 angularVelocity, float dt) {
+		float speed = glm::length(angularVelocity);
+
+		// se a bola não roda
+		if (speed == 0.0f || dt == 0.0f) {
+			return orientation;
+		}
+
+		// rotação exata de speed * dt radianos em torno do eixo (para intervalos longos, como entre eventos)
+		return glm::normalize(glm::angleAxis(speed * dt, angularVelocity / speed) * orientation);
+	}
+
+#pragma endregion
+
+}
@@ -0,0 +1,151 @@
+/*
+ * @descrição	Ficheiro com todas as assinaturas relativas à simulação física das bolas.
+ * @ficheiro	Physics.h
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+*/
+
+
+#pragma once
+
+#ifndef PHYSICS_H
+#define PHYSICS_H 1
+
+#pragma region importações
+
+#include <vector>
+
+#include <glm\glm.hpp>
+#include <glm\gtc\quaternion.hpp>
+
+#include "Broadphase.h"
+
+#pragma endregion
+
+
+#pragma region constantes
+
+#define BALL_RADIUS 0.08f				// raio de cada bola
+#define TABLE_HALF_WIDTH 1.25f			// metade da largura da mesa (eixo X)
+#define TABLE_HALF_DEPTH 1.25f			// metade da profundidade da mesa (eixo Z)
+#define PHYSICS_FREQUENCY 120.0			// frequência padrão da simulação (passos por segundo)
+#define PHYSICS_MAX_SUB_STEPS 8			// número máximo de passos executados por frame
+#define PHYSICS_COLLISION_PASSES 4		// número máximo de passagens de resolução de colisões por passo
+#define PHYSICS_GRAIN_SIZE 4096			// bolas por tarefa ao integrar em paralelo (abaixo disto corre na thread atual)
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region declarações da física
+
+	// estrutura com o estado de simulação de todas as bolas, guardado por componente (um array por campo),
+	// para que os ciclos da simulação percorram apenas a memória de que precisam
+	typedef struct {
+		std::vector<float> x, y, z;									// posição no passo atual
+		std::vector<float> previousX, previousY, previousZ;			// posição no passo anterior (para interpolação)
+		std::vector<float> vx, vy, vz;								// velocidade linear (unidades por segundo)
+		std::vector<float> qx, qy, qz, qw;							// orientação (quaternião unitário) no passo atual
+		std::vector<float> previousQx, previousQy, previousQz, previousQw;	// orientação no passo anterior (para interpolação)
+		std::vector<float> wx, wy, wz;								// rotação própria (efeito), somada à do rolamento (radianos por segundo)
+		int count;													// número de bolas
+	} BallStore;
+
+	// estrutura de um contacto resolvido durante a simulação
+	typedef struct {
+		int ballA;		// índice da primeira bola
+		int ballB;		// índice da segunda bola (-1 quando é uma tabela da mesa)
+	} Contact;
+
+	// interface comum aos motores de simulação (passo fixo ou por eventos)
+	class Simulation {
+	public:
+		// destrutor
+		virtual ~Simulation() {}
+
+		// getters - obter valores de atributos fora da classe
+		virtual int getNumberOfBalls() const = 0;
+		virtual glm::vec3 getPosition(int ball) const = 0;
+		virtual glm::quat getOrientation(int ball) const = 0;
+		virtual glm::vec3 getVelocity(int ball) const = 0;
+		virtual const std::vector<Contact>& getContacts() const = 0;
+		virtual bool isMoving() const = 0;
+
+		// setters - definir valores de atributos fora da classe
+		virtual void setVelocity(int ball, glm::vec3 velocity) = 0;
+		virtual void setAngularVelocity(int ball, glm::vec3 angularVelocity) = 0;
+
+		// principais
+		virtual int addBall(glm::vec3 position, glm::quat orientation) = 0;
+		virtual int update(double frameTime) = 0;
+		virtual void simulate(double duration) = 0;
+	};
+
+	// classe da simulação física com passo de tempo fixo
+	class Physics : public Simulation {
+	private:
+		// atributos privados
+		BallStore _balls;
+		std::vector<Contact> _contacts;		// contactos resolvidos na última atualização
+		UniformGrid _grid;					// broadphase com células do tamanho do diâmetro de uma bola
+		std::vector<int> _movingBalls;		// índices das bolas em movimento no passo atual (e das atingidas por elas)
+		std::vector<bool> _isMoving;		// se cada bola está em movimento no passo atual
+		std::vector<int> _correctedBalls;	// índices das bolas corrigidas na passagem de colisões atual
+		std::vector<bool> _isCorrected;		// se cada bola foi corrigida na passagem de colisões atual
+		PairList _pairs;					// pares candidatos a colisão no passo atual
+		std::vector<int> _hits;				// pares em contacto devolvidos pelo kernel da narrowphase
+		double _timeStep;					// duração de cada passo (segundos)
+		double _accumulator;				// tempo real ainda por simular
+		int _maxSubSteps;
+		float _friction;					// desaceleração por atrito (unidades por segundo ao quadrado)
+		long long _stepCount;
+
+		// secundárias
+		void step(float dt);
+		void integrate(float dt);
+		void solveCollisions(void);
+		void resolvePairs(void);
+		void solveCushions(int ball);
+		void markTouched(int ball);
+		void markCorrected(int ball);
+		void moveBall(int ball);
+
+	public:
+		// getters - obter valores de atributos fora da classe
+		int getNumberOfBalls() const override;
+		const BallStore& getBalls() const;
+		glm::vec3 getPosition(int ball) const override;
+		glm::quat getOrientation(int ball) const override;
+		glm::vec3 getVelocity(int ball) const override;
+		const std::vector<Contact>& getContacts() const override;
+		double getTimeStep() const;
+		double getInterpolation() const;
+		long long getStepCount() const;
+		bool isMoving() const override;
+
+		// setters - definir valores de atributos fora da classe
+		void setFrequency(double frequency);
+		void setMaxSubSteps(int maxSubSteps);
+		void setFriction(float friction);
+		void setVelocity(int ball, glm::vec3 velocity) override;
+		void setAngularVelocity(int ball, glm::vec3 angularVelocity) override;
+
+		// construtor
+		Physics(double frequency = PHYSICS_FREQUENCY, int maxSubSteps = PHYSICS_MAX_SUB_STEPS);
+
+		// principais
+		int addBall(glm::vec3 position, glm::quat orientation) override;
+		int update(double frameTime) override;
+		void simulate(double duration) override;
+	};
+
+	// funções globais da física
+	glm::vec3 getRollingAngularVelocity(glm::vec3 velocity);
+	glm::quat rotateOrientation(glm::quat orientation, glm::vec3 angularVelocity, float dt);
+
+#pragma endregion
+
+}
+
+#endif
@@ -15,7 +15,8 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <fstream>
+#include <cstring>
+#include <algorithm>
 
 #define GLEW_STATIC
 #include <GL\glew.h>
@@ -28,14 +29,12 @@
 #include <glm\gtc\matrix_transform.hpp>
 #include <glm\gtc\matrix_inverse.hpp>
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "thirdParty/TinyObjLoader.h"
-
-#define STB_IMAGE_IMPLEMENTATION
-#include "thirdParty/StbImage.h"
-
 #include "Shaders.h"
 #include "Pool.h"
+#include "Memory.h"
+#include "TextureBaker.h"
+#include "MappedFile.h"
+#include "TextParser.h"
 #include "Source.h"
 
 #pragma endregion
@@ -45,7 +44,10 @@ namespace Pool {
 
 #pragma region variáveis globais
 
-	GLuint _programShader;
+	ShaderVariants _programVariants;
+
+	// variantes já preparadas, por modelo de luz e por textura (criadas só quando são pedidas)
+	static ProgramVariant _variants[NUMBER_OF_LIGHT_MODELS][2];
 	glm::mat4 _modelMatrix;
 	glm::mat4 _viewMatrix;
 	glm::mat4 _projectionMatrix;
@@ -56,16 +58,57 @@ namespace Pool {
 
 #pragma region funções globais da biblioteca Pool
 
-	void bindProgramShader(GLuint* programShader) {
+	void bindProgramShader(ShaderProgram* programShader) {
 		// vincula o programa shader ao contexto OpenGL atual
-		glUseProgram(*programShader);
+		glUseProgram(programShader->getId());
+	}
+
+	ProgramVariant* getProgramVariant(int lightModel, bool isTextured) {
+		// se o modelo de luz não existe, usa a luz ambiente
+		if (lightModel < 1 || lightModel > NUMBER_OF_LIGHT_MODELS) {
+			lightModel = 1;
+		}
+
+		// se a variante já está preparada
+		ProgramVariant* variant = &_variants[lightModel - 1][isTextured ? 1 : 0];
+		if (variant->program) {
+			return variant;
+		}
+
+		// o modelo de luz e a textura são fixados no código do shader, em vez de serem testados em cada fragmento
+		std::string name = "light" + std::to_string(lightModel) + (isTextured ? "_textured" : "");
+		// as bolas (as únicas com textura) são desenhadas por instância; a mesa não
+		std::string defines = "#define LIGHT_MODEL " + std::to_string(lightModel) + "\n#define TEXTURED " + (isTextured ? "1" : "0") + "\n#define INSTANCED " + (isTextured ? "1" : "0") + "\n" + getTiledLightingDefines();
+
+		ShaderProgram* program = _programVariants.get(name.c_str(), defines.c_str());
+		if (!program) {
+			return nullptr;
+		}
+
+		variant->program = program;
+		resolveUniforms(program, &variant->uniforms);
+
+		// os uniforms pertencem a cada programa, por isso cada variante recebe o seu estado inicial
+		glm::mat4 modelViewMatrix = _viewMatrix * _modelMatrix;
+		sendUniformsToProgramShader(&variant->uniforms, &_modelMatrix, &modelViewMatrix, &_normalMatrix);
+		sendSamplersToProgramShader(&variant->uniforms);
+
+		return variant;
 	}
 
-	void sendAttributesToProgramShader(GLuint* programShader) {
+	void resolveUniforms(ShaderProgram* programShader, ProgramUniforms* uniforms) {
+		// obtém os handles a partir da tabela de reflexão, para não procurar os nomes em cada frame
+		uniforms->model = programShader->getUniform<glm::mat4>("Model");
+		uniforms->modelView = programShader->getUniform<glm::mat4>("ModelView");
+		uniforms->normalMatrix = programShader->getUniform<glm::mat3>("NormalMatrix");
+		uniforms->ballTextures = programShader->getUniform<int>("ballTextures");
+	}
+
+	void sendAttributesToProgramShader(ShaderProgram* programShader) {
 		// obtém as localizações dos atributos no programa shader
-		GLint positionId = glGetProgramResourceLocation(*programShader, GL_PROGRAM_INPUT, "vPosition");
-		GLint normalId = glGetProgramResourceLocation(*programShader, GL_PROGRAM_INPUT, "vNormal");
-		GLint textCoordId = glGetProgramResourceLocation(*programShader, GL_PROGRAM_INPUT, "vTextureCoord");
+		GLint positionId = programShader->getInputLocation("vPosition");
+		GLint normalId = programShader->getInputLocation("vNormal");
+		GLint textCoordId = programShader->getInputLocation("vTextureCoord");
 
 		// faz a ligação entre os atributos do programa shader aos VAOs e VBO ativos 
 		glVertexAttribPointer(positionId, 3 /*3 elementos por vértice*/, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
@@ -79,26 +122,20 @@ namespace Pool {
 	}
 
 	void sendUniformsToProgramShader(
-		GLuint* programShader,
+		ProgramUniforms* uniforms,
 		glm::mat4* modelMatrix,
-		glm::mat4* viewMatrix,
 		glm::mat4* modelViewMatrix,
-		glm::mat4* projectionMatrix,
 		glm::mat3* normalMatrix)
 	{
-		// obtém as localizações dos uniforms no programa shader
-		GLint modelId = glGetProgramResourceLocation(*programShader, GL_UNIFORM, "Model");
-		GLint viewId = glGetProgramResourceLocation(*programShader, GL_UNIFORM, "View");
-		GLint modelViewId = glGetProgramResourceLocation(*programShader, GL_UNIFORM, "ModelView");
-		GLint projectionId = glGetProgramResourceLocation(*programShader, GL_UNIFORM, "Projection");
-		GLint normalViewId = glGetProgramResourceLocation(*programShader, GL_UNIFORM, "NormalMatrix");
-
-		// atribui o valor aos uniforms do programa shader
-		glProgramUniformMatrix4fv(*programShader, modelId, 1, GL_FALSE, glm::value_ptr(*modelMatrix));
-		glProgramUniformMatrix4fv(*programShader, viewId, 1, GL_FALSE, glm::value_ptr(*viewMatrix));
-		glProgramUniformMatrix4fv(*programShader, modelViewId, 1, GL_FALSE, glm::value_ptr(*modelViewMatrix));
-		glProgramUniformMatrix4fv(*programShader, projectionId, 1, GL_FALSE, glm::value_ptr(*projectionMatrix));
-		glProgramUniformMatrix3fv(*programShader, normalViewId, 1, GL_FALSE, glm::value_ptr(*normalMatrix));
+		// atribui o valor aos uniforms do programa shader (a visualização e a projeção vão no bloco FrameData)
+		uniforms->model.set(*modelMatrix);
+		uniforms->modelView.set(*modelViewMatrix);
+		uniforms->normalMatrix.set(*normalMatrix);
+	}
+
+	void sendSamplersToProgramShader(ProgramUniforms* uniforms) {
+		// a textura de todas as bolas fica sempre na mesma unidade
+		uniforms->ballTextures.set(BALL_TEXTURE_UNIT);
 	}
 
 #pragma endregion
@@ -107,20 +144,20 @@ namespace Pool {
 #pragma region funções getters e setters da classe RendererBall
 
 	// getters
-	const std::vector<float>& RendererBall::getVertices() const {   // retorna apontador para ser mais eficiente ao renderizar
-		return *_vertices;
+	const MeshHandle& RendererBall::getMesh() const {   // o handle pode ser inválido se o .obj não foi carregado
+		return _mesh;
 	}
 
 	const Material& RendererBall::getMaterial() const {
 		return *_material;
 	}
 
-	glm::vec3 RendererBall::getPosition()const {
-		return _position;
+	const BallInstance& RendererBall::getInstance() const {
+		return _instance;
 	}
 
-	glm::vec3 RendererBall::getOrientation() const {
-		return _orientation;
+	const BoundingSphere& RendererBall::getBounds() const {
+		return _bounds;
 	}
 
 	// setters
@@ -129,11 +166,19 @@ namespace Pool {
 	}
 
 	void RendererBall::setPosition(glm::vec3 position) {
-		_position = position;
+		// só marca a matriz de modelo para recalcular se a bola se moveu
+		if (position != _position) {
+			_position = position;
+			_isModelDirty = true;
+		}
 	}
 
-	void RendererBall::setOrientation(glm::vec3 orientation) {
-		_orientation = orientation;
+	void RendererBall::setOrientation(glm::quat orientation) {
+		// só marca a matriz de modelo para recalcular se a bola rodou
+		if (orientation != _orientation) {
+			_orientation = orientation;
+			_isModelDirty = true;
+		}
 	}
 
 #pragma endregion
@@ -144,21 +189,24 @@ namespace Pool {
 	// construtor
 	RendererBall::RendererBall(void) {
 		_id = 0;
-		_objFilepath = new char;
-		_vertices = new std::vector<float>;
-		_vao = new GLuint;
-		_vbo = new GLuint;
-		_material = new Material;
-		_texture = new Texture;
+		_objFilepath = "";
+		_material = new Material();	// material por omissão, usado se o .mtl não for lido
+		_texture = nullptr;
+		_textureIndex = -1;
+		_materialIndex = 0;
+		_instance = BallInstance();
+		_bounds = { glm::vec3(0.0f), 0.0f };
+		_position = glm::vec3(0.0f);
+		_orientation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+		_isModelDirty = true;
+		_instanceView = glm::mat4(0.0f);	// nunca é igual a uma matriz de visualização válida
 	}
 
 	// destrutor
 	RendererBall::~RendererBall(void) {
 		// liberta memória
-		delete _vao;
-		delete _vbo;
 		delete _material;
-		delete _texture;
+		deleteTexture(_texture);
 	}
 
 #pragma endregion
@@ -167,279 +215,272 @@ namespace Pool {
 #pragma region funções principais da classe RendererBall
 
 	void RendererBall::Read(const std::string obj_model_filepath) {
-		_objFilepath = obj_model_filepath.c_str();
+		_objFilepath = obj_model_filepath;
 
-		// armazena o modelo 3D
-		_vertices = load3dModel(_objFilepath);
+		// obtém o modelo 3D do registo (só é lido se nenhuma bola com a mesma geometria o carregou)
+		// e o nome do ficheiro .mtl referenciado pelo .obj
+		std::string mtlFilename;
+		_mesh = getMeshRegistry().acquire(_objFilepath.c_str(), &mtlFilename);
 
-		// armazena o material
-		std::string mtlFilename = getMtlFromObj(_objFilepath);
-		_material = loadMaterial(mtlFilename.c_str());
+		// armazena o material (substitui o material por omissão, sem o perder)
+		Material* material = loadMaterial(mtlFilename.c_str());
+		if (material) {
+			delete _material;
+			_material = material;
+		}
 
-		// armazena a textura
-		std::string textureFilename = _material->map_kd;
-		_texture = loadTexture(textureFilename);
+		// armazena a textura (os níveis cozidos são libertados por TextureArray::Send, depois de enviados)
+		deleteTexture(_texture);
+		_texture = _material->map_kd.empty() ? nullptr : loadTexture(_material->map_kd);
 	}
 
-	void RendererBall::Send(void) {
-		// gera o nome para o VAO da bola
-		glGenVertexArrays(1, _vao);
-
-		// vincula o VAO da bola ao contexto OpenGL atual
-		glBindVertexArray(*_vao);
-
-		// gera o nome para o VBO da bola
-		glGenBuffers(1, _vbo);
-
-		// para cada vértice da da bola
-		for (int i = 0; i < _vertices->size(); i++) {
-			// vincula o VBO ao contexto OpenGL atual
-			glBindBuffer(GL_ARRAY_BUFFER, *_vbo);
+	void RendererBall::Send(TextureArray& textures, MaterialArray& materials) {
+		// envia a malha para a GPU (só a primeira bola que a usa o faz)
+		getMeshRegistry().send(_mesh);
 
-			// inicializa o VBO atualmente ativo com dados imutáveis
-			glBufferStorage(GL_ARRAY_BUFFER, _vertices->size() * sizeof(float), _vertices->data(), 0);
+		// a imagem é enviada junto com as das outras bolas, numa única textura (TextureArray::Send)
+		_textureIndex = textures.add(_texture);
 
-			// ativa atributos das posições dos vértices
-			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (void*)0);
-			glEnableVertexAttribArray(0);
+		// o material também fica num buffer partilhado, lido pelo shader através do índice da instância
+		_materialIndex = materials.add(_material->ns, _material->ka, _material->kd, _material->ks);
+	}
 
-			// ativa atributos das cores dos vértices
-			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (void*)(3 * sizeof(GLfloat)));
-			glEnableVertexAttribArray(1);
+	bool RendererBall::updateTransform(void) {
+		// só calcula matrizes (sem chamadas OpenGL), por isso pode correr fora da thread de renderização
+		// (_modelMatrix é fixa depois de init, por isso só a posição e a orientação tornam a matriz de modelo inválida)
+		bool isViewDirty = _viewMatrix != _instanceView;
 
-			// ativa atributos das coordenadas de textura dos vértices
-			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (void*)(6 * sizeof(GLfloat)));
-			glEnableVertexAttribArray(2);
-		
-			// desvincula o VAO atual
-			glBindVertexArray(0);
+		// se a bola está parada e a câmara não mudou, as matrizes da última frame continuam válidas
+		if (!_isModelDirty && !isViewDirty) {
+			return false;
 		}
 
-		// gera o nome para a textura
-		GLuint textureName;
-		glGenTextures(1, &textureName);
-
-		// ativa a unidade de textura atual (inicia na unidade 0)
-		glActiveTexture(GL_TEXTURE0 + (_id - 1));
-
-		// vincula um nome de textura ao target GL_TEXTURE_2D da unidade de textura ativa
-		glBindTexture(GL_TEXTURE_2D, textureName);
+		if (_isModelDirty) {
+			// rotação, escala e translação da bola numa só matriz, a partir do quaternião
+			// (em vez de uma translação, três rotações e uma escala, cada uma com a sua multiplicação de matrizes)
+			glm::mat4 ballModel = glm::mat4_cast(_orientation);
+			ballModel[0] *= 0.08f;
+			ballModel[1] *= 0.08f;
+			ballModel[2] *= 0.08f;
+			ballModel[3] = glm::vec4(_position, 1.0f);
+
+			_instance.model = _modelMatrix * ballModel;
+			_instance.indices = glm::ivec4(_textureIndex, _materialIndex, 0, 0);
+
+			// esfera envolvente da malha levada para o espaço do mundo, para o descarte por pirâmide de visão
+			if (_mesh.isValid()) {
+				_bounds = transformBoundingSphere(_mesh.getMesh()->bounds, _instance.model);
+			}
 
-		// define os parâmetros de filtragem (wrapping e ajuste de tamanho)
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			_isModelDirty = false;
+		}
 
-		// carrega os dados da imagem para o objeto de textura vinculado ao target GL_TEXTURE_2D da unidade de textura ativa
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _texture->width, _texture->height, 0, _texture->nChannels == 4 ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, _texture->image);
+		// matrizes dependentes da câmara, enviadas para a GPU por InstancedRenderer
+		glm::mat4 modelView = _viewMatrix * _instance.model;
+		_instance.modelView = modelView;
+		_instance.normalMatrix = glm::mat4(glm::inverseTranspose(glm::mat3(modelView)));
+		_instanceView = _viewMatrix;
 
-		// gera o mipmap para essa textura
-		glGenerateMipmap(GL_TEXTURE_2D);
+		return true;
 	}
 
-	void RendererBall::Draw(glm::vec3 position, glm::vec3 orientation) {
-		// atualizar valores de iluminação do objeto
-		Material* material = _material;
-		loadMaterialLighting(_programShader, *material);
+#pragma endregion
 
-		// translação da bola
-		glm::mat4 translatedModel = glm::translate(_modelMatrix, position);
 
-		// rotação da bola em torno do eixo Z
-		glm::mat4 rotatedModel = glm::rotate(translatedModel, glm::radians(orientation.z), glm::vec3(0.0f, 0.0f, 1.0f));	// rotação no eixo z
-		rotatedModel = glm::rotate(rotatedModel, glm::radians(orientation.y), glm::vec3(0.0f, 1.0f, 0.0f));					// rotação no eixo y
-		rotatedModel = glm::rotate(rotatedModel, glm::radians(orientation.x), glm::vec3(1.0f, 0.0f, 0.0f));					// rotação no eixo x
+#pragma region funções secundárias da classe RendererBall
 
-		// escala de cada bola
-		glm::mat4 scaledModel = glm::scale(rotatedModel, glm::vec3(0.08f));
+	Material* RendererBall::loadMaterial(const char* mtlFilename) {
+		std::string directory = "textures/";
+		MappedFile mtlFile;
 
-		// modelo de visualização do objeto
-		glm::mat4 modelView = _viewMatrix * scaledModel;
+		// se houve erros ao carregar o ficheiro .mtl
+		if (!mtlFile.open((directory + mtlFilename).c_str())) {
+			std::cerr << "Erro ao carregar ficheiro .mtl." << std::endl;
+			return {};
+		}
 
-		// obtém a localização do uniform
-		GLint modelViewId = glGetProgramResourceLocation(_programShader, GL_UNIFORM, "ModelView");
+		const char* p = (const char*)mtlFile.getData();
+		const char* end = p + mtlFile.getSize();
+		Pool::Material* material = new Material;
 
-		// atribui o valor ao uniform
-		glProgramUniformMatrix4fv(_programShader, modelViewId, 1, GL_FALSE, glm::value_ptr(modelView));
+		// lê cada linha do ficheiro .mtl (diretamente da memória mapeada) e guarda os respetivos dados
+		for (; p < end; p = skipLine(p, end)) {
+			p = skipSpaces(p, end);
 
-		// define que a mesa tem textura (valor 1)
-		GLint isRenderTexture = glGetProgramResourceLocation(_programShader, GL_UNIFORM, "isRenderTexture");
-		glProgramUniform1i(_programShader, isRenderTexture, 1);
+			// brilho
+			if (matchKeyword(p, end, "Ns")) {
+				parseFloat(p + 2, end, &material->ns);
+			}
+			// cor ambiente
+			else if (matchKeyword(p, end, "Ka")) {
+				p = parseFloat(p + 2, end, &material->ka.x);
+				p = parseFloat(p, end, &material->ka.y);
+				parseFloat(p, end, &material->ka.z);
+			}
+			// cor difusa
+			else if (matchKeyword(p, end, "Kd")) {
+				p = parseFloat(p + 2, end, &material->kd.x);
+				p = parseFloat(p, end, &material->kd.y);
+				parseFloat(p, end, &material->kd.z);
+			}
+			// cor especular
+			else if (matchKeyword(p, end, "Ks")) {
+				p = parseFloat(p + 2, end, &material->ks.x);
+				p = parseFloat(p, end, &material->ks.y);
+				parseFloat(p, end, &material->ks.z);
+			}
+			// textura
+			else if (matchKeyword(p, end, "map_Kd")) {
+				const char* texture;
+				size_t length;
+				parseToken(p + 6, end, &texture, &length);
 
-		GLint locationTexSampler1 = glGetProgramResourceLocation(_programShader, GL_UNIFORM, "sampler");
-		glProgramUniform1i(_programShader, locationTexSampler1, (_id - 1)/*unidade de textura*/);
+				material->map_kd.assign(texture, length);
+			}
+		}
 
-		// desenha a bola na tela
-		glBindVertexArray(0);
-		glDrawArrays(GL_TRIANGLES, 0, _vertices->size() / 8);
+		return material;
 	}
 
-#pragma endregion
+	Texture* RendererBall::loadTexture(std::string imageFilename) {
+		// lê a textura cozida (todos os níveis de mipmap prontos a enviar) ou coze-a a partir da imagem
+		std::string directory = "textures/";
+		std::string fullPath = directory + imageFilename;
+		Texture* texture = loadBakedTexture(fullPath.c_str());
 
+		// se houve erros ao abrir o ficheiro
+		if (!texture) {
+			std::cerr << "Erro ao abrir o ficheiro '" << fullPath.c_str() << "'." << std::endl;
+		}
 
-#pragma region funções secundárias da classe RendererBall
+		return texture;
+	}
 
-	std::vector<float>* RendererBall::load3dModel(const char* objFilepath) {
-		std::vector<float>* vertices = new 	std::vector<float>;
+#pragma endregion
 
-		tinyobj::attrib_t attributes;
-		std::vector<tinyobj::shape_t> shapes;
-		std::vector<tinyobj::material_t> materials;
-		std::string warning, error;
+#pragma region funções getters e setters da classe InstancedRenderer
 
-		// se houve erros ao carregar o ficheiro .obj
-		if (!tinyobj::LoadObj(&attributes, &shapes, &materials, &warning, &error, objFilepath)) {
-			std::cout << warning << error << '\n';
-			return nullptr;
-		}
+	// getters
+	int InstancedRenderer::getNumberOfInstances() const {
+		return (int)_instances.size();
+	}
 
-		// lê atributos do modelo 3D
-		for (const auto& shape : shapes) {
-			for (const auto& index : shape.mesh.indices) {
-				glm::vec4 pos = {
-					attributes.vertices[3 * index.vertex_index],
-					attributes.vertices[3 * index.vertex_index + 1],
-					attributes.vertices[3 * index.vertex_index + 2],
-					1
-				};
-
-				glm::vec3 normal = {
-					attributes.normals[3 * index.normal_index],
-					attributes.normals[3 * index.normal_index + 1],
-					attributes.normals[3 * index.normal_index + 2]
-				};
-
-				glm::vec2 textCoord = {
-					attributes.texcoords[2 * index.texcoord_index],
-					attributes.texcoords[2 * index.texcoord_index + 1]
-				};
-
-				vertices->push_back(pos.x);
-				vertices->push_back(pos.y);
-				vertices->push_back(pos.z);
-				vertices->push_back(normal.x);
-				vertices->push_back(normal.y);
-				vertices->push_back(normal.z);
-				vertices->push_back(textCoord.x);
-				vertices->push_back(textCoord.y);
-			}
-		}
+	// setters
+	void InstancedRenderer::setNumberOfInstances(int numberOfInstances) {
+		_instances.resize(numberOfInstances);
+		_meshes.resize(numberOfInstances, nullptr);
+	}
 
-		return vertices;
+	void InstancedRenderer::setInstance(int index, const MeshHandle& mesh, const BallInstance& instance) {
+		_instances[index] = instance;
+		_meshes[index] = mesh.getMesh();
 	}
 
-	std::string RendererBall::getMtlFromObj(const char* objFilepath) {
-		std::ifstream file(objFilepath);
-		std::string line;
-		std::string mtlFilename;
+#pragma endregion
 
-		while (std::getline(file, line)) {
-			std::istringstream stream(line);
-			std::string prefix;
-			stream >> prefix;
 
-			if (prefix == "mtllib") {
-				stream >> mtlFilename;
-				break;
-			}
-		}
+#pragma region construtor e destrutor da classe InstancedRenderer
 
-		return mtlFilename;
+	// construtor
+	InstancedRenderer::InstancedRenderer(void) {
+		_instanceBuffer = 0;
+		_capacity = 0;
+		_offsetAlignment = 0;
 	}
 
-	Material* RendererBall::loadMaterial(const char* mtlFilename) {
-		std::string directory = "textures/";
-		std::ifstream mtlFile(directory + mtlFilename);
-
-		// se houve erros ao carregar o ficheiro .mtl
-		if (!mtlFile) {
-			std::cerr << "Erro ao carregar ficheiro .mtl." << std::endl;
-			return {};
+	// destrutor
+	InstancedRenderer::~InstancedRenderer(void) {
+		// o buffer só pode ser apagado enquanto existir um contexto OpenGL
+		if (_instanceBuffer && glfwGetCurrentContext()) {
+			trackGpuMemory(MEMORY_BUFFERS, -(long long)_capacity);
+			glDeleteBuffers(1, &_instanceBuffer);
 		}
+	}
 
-		std::string line;
-		Pool::Material* material = new Material;
+#pragma endregion
 
-		// lê cada linha do ficheiro .mtl e guarda os respetivos dados
-		while (std::getline(mtlFile, line)) {
-			// ignora linhas vazias ou comentadas
-			if (line.empty() || line[0] == '#') {
-				continue;
-			}
 
-			std::istringstream stream(line);
-			std::string command;
-			stream >> command;
+#pragma region funções principais da classe InstancedRenderer
 
-			// brilho
-			if (command == "Ns") {
-				float value;
-				stream >> value;
+	void InstancedRenderer::Draw(TextureArray& textures, MaterialArray& materials) {
+		int numberOfInstances = (int)_instances.size();
 
-				material->ns = value;
-			}
-			// cor ambiente
-			else if (command == "Ka") {
-				float r, g, b;
-				stream >> r >> g >> b;
+		// se não há instâncias para desenhar
+		if (numberOfInstances == 0) {
+			return;
+		}
 
-				material->ka = glm::vec3(r, g, b);
-			}
-			// cor difusa
-			else if (command == "Kd") {
-				float r, g, b;
-				stream >> r >> g >> b;
+		// cada grupo começa num múltiplo do alinhamento exigido por glBindBufferRange
+		if (_offsetAlignment == 0) {
+			glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &_offsetAlignment);
+			_offsetAlignment = std::max(_offsetAlignment, (GLint)1);
+		}
 
-				material->kd = glm::vec3(r, g, b);
+		// malhas distintas, pela ordem da primeira bola que as usa (as que não foram carregadas não são desenhadas)
+		_groupMeshes.clear();
+		for (int i = 0; i < numberOfInstances; i++) {
+			if (_meshes[i] && _meshes[i]->isSent && std::find(_groupMeshes.begin(), _groupMeshes.end(), _meshes[i]) == _groupMeshes.end()) {
+				_groupMeshes.push_back(_meshes[i]);
 			}
-			// cor especular
-			else if (command == "Ks") {
-				float r, g, b;
-				stream >> r >> g >> b;
+		}
 
-				material->ks = glm::vec3(r, g, b);
-			}
-			// textura
-			else if (command == "map_Kd") {
-				std::string texture;
-				stream >> texture;
+		// se nenhuma malha está pronta a desenhar
+		if (_groupMeshes.empty()) {
+			return;
+		}
 
-				material->map_kd = texture;
+		// junta as instâncias de cada malha num bloco contíguo e alinhado
+		_groupOffsets.assign(_groupMeshes.size(), 0);
+		_groupCounts.assign(_groupMeshes.size(), 0);
+		size_t size = 0;
+		_staging.resize((size_t)numberOfInstances * sizeof(BallInstance) + _groupMeshes.size() * (size_t)_offsetAlignment);
+
+		for (size_t group = 0; group < _groupMeshes.size(); group++) {
+			size = (size + _offsetAlignment - 1) / _offsetAlignment * _offsetAlignment;
+			_groupOffsets[group] = size;
+
+			for (int i = 0; i < numberOfInstances; i++) {
+				if (_meshes[i] == _groupMeshes[group]) {
+					std::memcpy(_staging.data() + size, &_instances[i], sizeof(BallInstance));
+					size += sizeof(BallInstance);
+					_groupCounts[group]++;
+				}
 			}
 		}
 
-		return material;
-	}
-
-	Texture* RendererBall::loadTexture(std::string imageFilename) {
-		Texture* texture = new Texture;
-		int width, height, nChannels;
+		// se as instâncias não cabem no buffer, cria um maior (com folga, para não o recriar a cada bola nova)
+		if (size > _capacity) {
+			if (_instanceBuffer) {
+				trackGpuMemory(MEMORY_BUFFERS, -(long long)_capacity);
+				glDeleteBuffers(1, &_instanceBuffer);
+			}
 
-		// lê o ficheiro da imagem
-		std::string directory = "textures/";
-		std::string fullPath = directory + imageFilename;
-		unsigned char* image = stbi_load(fullPath.c_str(), &width, &height, &nChannels, 0);
+			_capacity = std::max(size, 2 * _capacity);
 
-		// se houve erros ao abrir o ficheiro
-		if (!image) {
-			std::cerr << "Erro ao abrir o ficheiro '" << fullPath.c_str() << "'." << std::endl;
-			return {};
+			glGenBuffers(1, &_instanceBuffer);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, _instanceBuffer);
+			glBufferStorage(GL_SHADER_STORAGE_BUFFER, _capacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+			trackGpuMemory(MEMORY_BUFFERS, (long long)_capacity);
 		}
 
-		texture->width = width;
-		texture->height = height;
-		texture->nChannels = nChannels;
-		texture->image = image;
+		// envia os dados de todas as instâncias de uma só vez
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, _instanceBuffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, _staging.data());
 
-		return texture;
-	}
+		// as imagens e os materiais de todas as bolas estão numa só textura e num só buffer, ligados uma só vez
+		textures.Bind();
+		materials.Bind();
+
+		// uma chamada por malha distinta: o bloco BallInstances (binding 0) aponta para o grupo dessa malha,
+		// por isso gl_InstanceID indexa as instâncias do grupo
+		// (com o programa das bolas vinculado: variante com textura, que lê os dados do buffer de instâncias)
+		for (size_t group = 0; group < _groupMeshes.size(); group++) {
+			const Mesh* mesh = _groupMeshes[group];
 
-	void RendererBall::loadMaterialLighting(GLuint programShader, Material material) {
-		glProgramUniform1f(programShader, glGetProgramResourceLocation(programShader, GL_UNIFORM, "material.shininess"), material.ns);
-		glProgramUniform3fv(programShader, glGetProgramResourceLocation(programShader, GL_UNIFORM, "material.ambient"), 1, glm::value_ptr(material.ka));
-		glProgramUniform3fv(programShader, glGetProgramResourceLocation(programShader, GL_UNIFORM, "material.diffuse"), 1, glm::value_ptr(material.kd));
-		glProgramUniform3fv(programShader, glGetProgramResourceLocation(programShader, GL_UNIFORM, "material.specular"), 1, glm::value_ptr(material.ks));
+			glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0 /*binding de BallInstances*/, _instanceBuffer, _groupOffsets[group], _groupCounts[group] * sizeof(BallInstance));
+			glBindVertexArray(mesh->vao);
+			glDrawElementsInstanced(GL_TRIANGLES, mesh->numberOfIndices, mesh->indexType, (void*)0, _groupCounts[group]);
+		}
 	}
 
 #pragma endregion
@@ -1,7 +1,7 @@
 /*
- * @descrio	Ficheiro com todas as assinaturas relativas  biblioteca Pool.
+ * @descrição	Ficheiro com todas as assinaturas relativas à biblioteca Pool.
  * @ficheiro	Pool.h
- * @autor(s)	Henrique Azevedo a23488, Lus Pereira a18446, Pedro Silva a20721, Vnia Pereira a19264
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
  * @data		11/06/2023
 */
 
@@ -11,7 +11,7 @@
 #ifndef POOL_BALLS_H
 #define POOL_BALLS_H 1
 
-#pragma region importaes
+#pragma region importações
 
 #include <iostream>
 #include <vector>
@@ -26,69 +26,106 @@
 #include <glm\gtc\type_ptr.hpp>
 #include <glm\gtc\matrix_transform.hpp>
 #include <glm\gtc\matrix_inverse.hpp>
+#include <glm\gtc\quaternion.hpp>
+
+#include "Shaders.h"
+#include "Mesh.h"
+#include "Culling.h"
+#include "Textures.h"
+#include "UniformBuffers.h"
+#include "Lights.h"
+
+#pragma endregion
+
+
+#pragma region constantes
+
+#define NUMBER_OF_LIGHT_MODELS 5	// modelos de luz com variante própria do programa shader (1 ambiente, 2 direcional, 3 pontual, 4 cónica, 5 lista de luzes)
 
 #pragma endregion
 
 
 namespace Pool {
 
-#pragma region declaraes da biblioteca
+#pragma region declarações da biblioteca
 
 	// estrutura para armazenados dados dos ficheiros .mtl
 	typedef struct {
 		float ns;				// expoente especular (brilho do objeto)
-		glm::vec3 ka;			// coeficiente de reflexo da luz ambiente
-		glm::vec3 kd;			// coeficiente de reflexo da luz difusa
-		glm::vec3 ks;			// coeficiente de reflexo da luz especular 
+		glm::vec3 ka;			// coeficiente de reflexão da luz ambiente
+		glm::vec3 kd;			// coeficiente de reflexão da luz difusa
+		glm::vec3 ks;			// coeficiente de reflexão da luz especular 
 		std::string map_kd;		// nome do ficheiro da imagem de textura
 	} Material;
 
-	// estrutura para armazenados dados das texturas
+	// estrutura dos dados de cada bola desenhada por instância (std430, igual a BallInstance nos shaders)
+	typedef struct {
+		glm::mat4 model;			// transformação do modelo
+		glm::mat4 modelView;		// transformação do modelo de visualização
+		glm::mat4 normalMatrix;		// matriz das normais (só a parte 3x3 é usada)
+		glm::ivec4 indices;			// x: índice da imagem em TextureArray (-1 sem textura), y: índice do material em MaterialArray
+	} BallInstance;
+
+	// estrutura com os handles dos uniforms de cada objeto, resolvidos uma só vez depois de linkar
+	// (a câmara e as luzes estão nos blocos FrameData e Lights, ver UniformBuffers.h)
 	typedef struct {
-		int width;				// largura da textura
-		int height;				// altura da textura
-		int nChannels;			// nmero de canais de cores
-		unsigned char* image;	// imagem da textura
-	} Texture;
-
-	// variveis globais
-	extern GLuint _programShader;
+		Uniform<glm::mat4> model;
+		Uniform<glm::mat4> modelView;
+		Uniform<glm::mat3> normalMatrix;
+		Uniform<int> ballTextures;
+	} ProgramUniforms;
+
+	// estrutura de uma variante do programa shader (modelo de luz, com ou sem textura) e dos seus handles
+	typedef struct {
+		ShaderProgram* program;
+		ProgramUniforms uniforms;
+	} ProgramVariant;
+
+	// variáveis globais
+	extern ShaderVariants _programVariants;
 	extern glm::mat4 _modelMatrix;
 	extern glm::mat4 _viewMatrix;
 	extern glm::mat4 _projectionMatrix;
 	extern glm::mat3 _normalMatrix;
 
-	// funes globais da biblioteca
-	void bindProgramShader(GLuint* programShader);
-	void sendAttributesToProgramShader(GLuint* programShader);
-	void sendUniformsToProgramShader(GLuint* programShader, glm::mat4* modelMatrix, glm::mat4* viewMatrix, glm::mat4* modelViewMatrix, glm::mat4* projectionMatrix, glm::mat3* normalMatrix);
+	// funções globais da biblioteca
+	void bindProgramShader(ShaderProgram* programShader);
+	ProgramVariant* getProgramVariant(int lightModel, bool isTextured);
+	void resolveUniforms(ShaderProgram* programShader, ProgramUniforms* uniforms);
+	void sendAttributesToProgramShader(ShaderProgram* programShader);
+	void sendUniformsToProgramShader(ProgramUniforms* uniforms, glm::mat4* modelMatrix, glm::mat4* modelViewMatrix, glm::mat3* normalMatrix);
+	void sendSamplersToProgramShader(ProgramUniforms* uniforms);
 
 	// classe para renderizar bolas
 	class RendererBall {
 	private:
 		// atributos privados
-		int _id;	// identificador nico para depois saber qual a unidade de textura que pertence, entre outros dados, que este seja til
-		glm::vec3 _position;
-		glm::vec3 _orientation;
+		int _id;	// identificador único para depois saber qual a unidade de textura que pertence, entre outros dados, que este seja útil
 
-		const char* _objFilepath;
-		std::vector<float>* _vertices;
-		GLuint* _vao;
-		GLuint* _vbo;
+		std::string _objFilepath;
+		MeshHandle _mesh;	// malha partilhada com as outras bolas com a mesma geometria
 		Material* _material;
 		Texture* _texture;
+		int _textureIndex;		// índice da imagem da bola na textura partilhada por todas as bolas
+		int _materialIndex;		// índice do material da bola no buffer partilhado por todas as bolas
+		BallInstance _instance;	// dados da instância calculados em updateTransform
+		BoundingSphere _bounds;	// esfera envolvente no espaço do mundo, calculada em updateTransform
+		glm::vec3 _position;
+		glm::quat _orientation;	// orientação da bola (quaternião unitário, integrado pela simulação física)
+		bool _isModelDirty;		// se a posição ou a orientação mudaram desde o último cálculo da matriz de modelo
+		glm::mat4 _instanceView;	// matriz de visualização usada no último cálculo das matrizes dependentes da câmara
 
 	public:
 		// getters - definir valores de atributos fora da classe
-		const std::vector<float>& getVertices() const;
+		const MeshHandle& getMesh() const;
 		const Material& getMaterial() const;
-		glm::vec3 getPosition() const;
-		glm::vec3 getOrientation() const;
+		const BallInstance& getInstance() const;
+		const BoundingSphere& getBounds() const;
 
 		// setters - obter valores de atributos fora da classe
 		void setId(int id);
 		void setPosition(glm::vec3 position);
-		void setOrientation(glm::vec3 orientation);
+		void setOrientation(glm::quat orientation);
 
 		// construtor
 		RendererBall();
@@ -98,15 +135,44 @@ namespace Pool {
 
 		// principais
 		void Read(const std::string obj_model_filepath);
-		void Send(void);
-		void Draw(glm::vec3 position, glm::vec3 orientation);
+		void Send(TextureArray& textures, MaterialArray& materials);
+		bool updateTransform(void);
 
-		// secundrias
-		std::vector<float>* load3dModel(const char* objFilepath);
-		std::string getMtlFromObj(const char* objFilepath);
+		// secundárias
 		Material* loadMaterial(const char* mtlFilename);
 		Texture* loadTexture(std::string imageFilename);
-		void loadMaterialLighting(GLuint programShader, Material material);
+	};
+
+	// classe para desenhar várias bolas numa chamada por malha distinta (renderização por instâncias)
+	class InstancedRenderer {
+	private:
+		// atributos privados
+		GLuint _instanceBuffer;					// SSBO com os dados de cada instância
+		size_t _capacity;						// bytes que cabem no buffer
+		GLint _offsetAlignment;					// alinhamento do início de cada grupo no SSBO (GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT)
+		std::vector<BallInstance> _instances;
+		std::vector<const Mesh*> _meshes;		// malha de cada instância
+		std::vector<const Mesh*> _groupMeshes;	// malhas distintas das instâncias deste frame
+		std::vector<size_t> _groupOffsets;		// posição de cada grupo no SSBO, em bytes
+		std::vector<int> _groupCounts;			// instâncias de cada grupo
+		std::vector<unsigned char> _staging;	// instâncias agrupadas por malha, cada grupo alinhado, enviadas de uma só vez
+
+	public:
+		// getters - obter valores de atributos fora da classe
+		int getNumberOfInstances() const;
+
+		// setters - definir valores de atributos fora da classe
+		void setNumberOfInstances(int numberOfInstances);
+		void setInstance(int index, const MeshHandle& mesh, const BallInstance& instance);
+
+		// construtor
+		InstancedRenderer();
+
+		// destrutor
+		~InstancedRenderer();
+
+		// principais
+		void Draw(TextureArray& textures, MaterialArray& materials);
 	};
 
 #pragma endregion
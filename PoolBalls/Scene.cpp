@@ -0,0 +1,71 @@
+﻿/*
+ * @descrição	Ficheiro com todo o código relativo à disposição inicial da cena (sem dependências de OpenGL).
+ * @ficheiro	Scene.cpp
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+ *
+ * -------------------------------------
+ *
+ * Partilhado pela aplicação com janela e pela simulação em lote, que não cria contexto OpenGL.
+*/
+
+
+#pragma region importações
+
+#include <vector>
+
+#include <glm\glm.hpp>
+
+#include "Physics.h"
+#include "Scene.h"
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region funções da cena
+
+	const std::vector<glm::vec3>& getInitialBallPositions(void) {
+		// posições das bolas
+		static const std::vector<glm::vec3> positions = {
+			glm::vec3(1.1f, 0.33f, 1.1f),		// bola 1
+			glm::vec3(-1.1f, 0.33f, -1.1f),		// bola 2
+			glm::vec3(-1.1f, 0.33f, 1.1f),		// bola 3
+			glm::vec3(1.1f, 0.33f, -1.1f),		// bola 4
+			glm::vec3(0.1f, 0.33f, -0.1f),		// bola 5
+			glm::vec3(-0.3f, 0.33f, -0.3f),		// bola 6
+			glm::vec3(-0.6f, 0.33f, -0.4f),		// bola 7
+			glm::vec3(0.8f, 0.33f, 0.7f),		// bola 8
+			glm::vec3(-0.8f, 0.33f, -0.2f),		// bola 9
+			glm::vec3(0.3f, 0.33f, 0.7f),		// bola 10
+			glm::vec3(-0.2f, 0.33f, -0.8f),		// bola 11
+			glm::vec3(0.7f, 0.33f, 0.5f),		// bola 12
+			glm::vec3(-0.9f, 0.33f, 0.6f),		// bola 13
+			glm::vec3(0.1f, 0.33f, 0.3f),		// bola 14
+			glm::vec3(0.4f, 0.33f, -0.6f),		// bola 15
+		};
+
+		return positions;
+	}
+
+	const std::vector<glm::quat>& getInitialBallOrientations(void) {
+		// orientações das bolas (todas começam sem rotação: quaternião identidade)
+		static const std::vector<glm::quat> orientations(NUMBER_OF_BALLS, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+
+		return orientations;
+	}
+
+	void loadScene(Simulation* simulation) {
+		const std::vector<glm::vec3>& positions = getInitialBallPositions();
+		const std::vector<glm::quat>& orientations = getInitialBallOrientations();
+
+		// o estado de cada bola passa a pertencer à simulação física
+		for (int i = 0; i < NUMBER_OF_BALLS; i++) {
+			simulation->addBall(positions[i], orientations[i]);
+		}
+	}
+
+#pragma endregion
+
+}
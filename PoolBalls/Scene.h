@@ -0,0 +1,45 @@
+/*
+ * @descrição	Ficheiro com todas as assinaturas relativas à disposição inicial da cena (sem dependências de OpenGL).
+ * @ficheiro	Scene.h
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+*/
+
+
+#pragma once
+
+#ifndef SCENE_H
+#define SCENE_H 1
+
+#pragma region importações
+
+#include <vector>
+
+#include <glm\glm.hpp>
+#include <glm\gtc\quaternion.hpp>
+
+#include "Physics.h"
+
+#pragma endregion
+
+
+#pragma region constantes
+
+#define NUMBER_OF_BALLS 15
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region funções da cena
+
+	const std::vector<glm::vec3>& getInitialBallPositions(void);
+	const std::vector<glm::quat>& getInitialBallOrientations(void);
+	void loadScene(Simulation* simulation);
+
+#pragma endregion
+
+}
+
+#endif
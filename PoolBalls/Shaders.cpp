@@ -10,6 +10,18 @@
 
 #include <iostream>
 #include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
 
 #define GLEW_STATIC
 #include <GL\glew.h>
@@ -58,41 +70,96 @@ static const GLchar* readShader(const char* filename) {
 	return const_cast<const GLchar*>(source);
 }
 
-GLuint loadShaders(ShaderInfo* shaders) {
+// destroi os shaders criados (depois de um erro, ou depois de linkar)
+static void deleteShaders(ShaderInfo* shaders) {
+	for (int j = 0; shaders[j].type != GL_NONE; j++) {
+		// se tem um shader válido
+		if (shaders[j].shader != 0) {
+			glDeleteShader(shaders[j].shader);
+		}
+
+		shaders[j].shader = 0;
+	}
+}
+
+// liberta o código lido dos ficheiros
+static void deleteSources(std::vector<const GLchar*>* sources) {
+	for (const GLchar* source : *sources) {
+		delete[] source;
+	}
+
+	sources->clear();
+}
+
+// insere os #define logo a seguir à linha #version (que tem de ser a primeira do shader)
+static const GLchar* injectDefines(const GLchar* source, const char* defines) {
+	std::string code(source);
+	size_t position = 0;
+
+	size_t version = code.find("#version");
+	if (version != std::string::npos) {
+		position = code.find('\n', version);
+		position = position == std::string::npos ? code.size() : position + 1;
+	}
+
+	code.insert(position, defines);
+
+	GLchar* result = new GLchar[code.size() + 1];
+	std::memcpy(result, code.c_str(), code.size() + 1);
+
+	return result;
+}
+
+ShaderProgram loadShaders(ShaderInfo* shaders, const char* defines, const char* variantName) {
 	// se não forem passados shaders
 	if (shaders == nullptr) {
-		return -1;
+		return ShaderProgram();
 	}
 
-	// cria um objeto programa
-	GLuint program = glCreateProgram();
-
-	// para cada objeto shader
+	// lê o código de todos os shaders (também é a chave da cache, por isso é lido mesmo que o binário exista)
+	std::vector<const GLchar*> sources;
 	for (GLint i = 0; shaders[i].type != GL_NONE; i++) {
-		// cria um objeto shader
-		shaders[i].shader = glCreateShader(shaders[i].type);
+		shaders[i].shader = 0;
 
-		// lê o código do shader
 		const GLchar* source = readShader(shaders[i].filename);
 
 		// se houve erros com algum shader
 		if (source == nullptr) {
-			// destroi os shaders criados
-			for (int j = 0; shaders[j].type != GL_NONE; j++) {
-				// se tem um shader válido
-				if (shaders[j].shader != 0) {
-					glDeleteShader(shaders[j].shader);
-				}
-
-				shaders[j].shader = 0;
-			}
+			deleteSources(&sources);
+			return ShaderProgram();
+		}
 
-			return -1;
+		// se é uma variante, o código é especializado pelos #define antes de compilar
+		if (defines != nullptr && defines[0] != '\0') {
+			const GLchar* specialized = injectDefines(source, defines);
+			delete[] source;
+			source = specialized;
 		}
 
+		sources.push_back(source);
+	}
+
+	// se o driver já tem o programa compilado para este código, não é preciso compilar nem linkar
+	unsigned long long key = hashProgramSources(shaders, sources.data());
+	std::string cacheFilepath = getProgramCachePath(shaders, variantName);
+
+	GLuint program = loadProgramBinary(cacheFilepath.c_str(), key);
+	if (program != 0) {
+		deleteSources(&sources);
+		return ShaderProgram(program, true);
+	}
+
+	// cria um objeto programa, pedindo ao driver que guarde o binário para a próxima execução
+	program = glCreateProgram();
+	glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+	// para cada objeto shader
+	for (GLint i = 0; shaders[i].type != GL_NONE; i++) {
+		// cria um objeto shader
+		shaders[i].shader = glCreateShader(shaders[i].type);
+
 		// carrega o código do shader
-		glShaderSource(shaders[i].shader, 1, &source, nullptr);
-		delete[] source;
+		glShaderSource(shaders[i].shader, 1, &sources[i], nullptr);
 
 		// compila o shader
 		glCompileShader(shaders[i].shader);
@@ -113,23 +180,19 @@ GLuint loadShaders(ShaderInfo* shaders) {
 			std::cerr << "Erro ao compilar shaders: " << log << std::endl;
 			delete[] log;
 
-			// destroi os shaders criados
-			for (int j = 0; shaders[j].type != GL_NONE; j++) {
-				// se tem um shader válido
-				if (shaders[j].shader != 0) {
-					glDeleteShader(shaders[j].shader);
-				}
+			deleteShaders(shaders);
+			deleteSources(&sources);
+			glDeleteProgram(program);
 
-				shaders[j].shader = 0;
-			}
-
-			return -1;
+			return ShaderProgram();
 		}
 
 		// anexa o objeto shader ao programa shader
 		glAttachShader(program, shaders[i].shader);
 	}
 
+	deleteSources(&sources);
+
 	// linka o programa (cria um "executável")
 	glLinkProgram(program);
 
@@ -149,20 +212,417 @@ GLuint loadShaders(ShaderInfo* shaders) {
 		std::cerr << "Erro ao linkar shaders: " << log << std::endl;
 		delete[] log;
 
-		// destroi os shaders criados
-		for (int j = 0; shaders[j].type != GL_NONE; j++) {
-			// se tem um shader válido
-			if (shaders[j].shader != 0) {
-				glDeleteShader(shaders[j].shader);
-			}
+		deleteShaders(shaders);
+		glDeleteProgram(program);
 
-			shaders[j].shader = 0;
+		return ShaderProgram();
+	}
+
+	// guarda o binário para as próximas execuções (se falhar, o programa volta a ser compilado)
+	saveProgramBinary(cacheFilepath.c_str(), key, program);
+
+	// obtém a tabela de reflexão dos uniforms e blocos ativos
+	return ShaderProgram(program);
+}
+
+#pragma endregion
+
+#pragma region funções da cache de binários dos programas
+
+static const unsigned long long FNV_OFFSET_BASIS = 14695981039346656037ULL;
+static const unsigned long long FNV_PRIME = 1099511628211ULL;
+
+static unsigned long long hashBytes(unsigned long long hash, const void* data, size_t size) {
+	const unsigned char* bytes = (const unsigned char*)data;
+
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ bytes[i]) * FNV_PRIME;
+	}
+
+	return hash;
+}
+
+unsigned long long hashProgramSources(ShaderInfo* shaders, const GLchar* const* sources) {
+	unsigned long long hash = FNV_OFFSET_BASIS;
+	unsigned int version = PROGRAM_CACHE_VERSION;
+	hash = hashBytes(hash, &version, sizeof(version));
+
+	// código e tipo de cada shader
+	for (int i = 0; shaders[i].type != GL_NONE; i++) {
+		hash = hashBytes(hash, &shaders[i].type, sizeof(shaders[i].type));
+		hash = hashBytes(hash, sources[i], std::strlen(sources[i]));
+	}
+
+	// o binário só é válido no mesmo driver (uma atualização muda a versão e invalida a cache)
+	const GLenum names[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+	for (GLenum name : names) {
+		const char* value = (const char*)glGetString(name);
+		if (value) {
+			hash = hashBytes(hash, value, std::strlen(value));
 		}
+	}
+
+	return hash;
+}
+
+std::string getProgramCachePath(ShaderInfo* shaders, const char* variantName) {
+	// pasta do executável
+	std::string directory;
+#ifdef _WIN32
+	char path[MAX_PATH];
+	DWORD length = GetModuleFileNameA(nullptr, path, MAX_PATH);
+#else
+	char path[4096];
+	ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+#endif
+	if (length > 0) {
+		std::string executable(path, (size_t)length);
+		size_t separator = executable.find_last_of("\\/");
+		if (separator != std::string::npos) {
+			directory = executable.substr(0, separator + 1);
+		}
+	}
+
+	// nome do primeiro shader sem pasta nem extensão ("shaders/Pool.vert" -> "Pool.program")
+	std::string name = shaders[0].filename;
+	size_t separator = name.find_last_of("\\/");
+	if (separator != std::string::npos) {
+		name = name.substr(separator + 1);
+	}
+	size_t extension = name.find_last_of('.');
+	if (extension != std::string::npos) {
+		name = name.substr(0, extension);
+	}
+
+	// cada variante tem o seu ficheiro ("Pool_light2_textured.program")
+	if (variantName != nullptr && variantName[0] != '\0') {
+		name = name + "_" + variantName;
+	}
+
+	return directory + name + PROGRAM_CACHE_EXTENSION;
+}
+
+GLuint loadProgramBinary(const char* cacheFilepath, unsigned long long key) {
+	// se o driver não suporta nenhum formato de binário
+	GLint numberOfFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numberOfFormats);
+	if (numberOfFormats == 0) {
+		return 0;
+	}
+
+	// abre o ficheiro no fim, para obter o tamanho
+	std::ifstream file(cacheFilepath, std::ios::binary | std::ios::ate);
+	if (!file) {
+		return 0;
+	}
+	unsigned long long fileSize = (unsigned long long)file.tellg();
+	file.seekg(0);
+
+	// se o ficheiro não é uma cache desta versão, ou foi criada para outro código ou outro driver
+	ProgramCacheHeader header;
+	if (!file.read((char*)&header, sizeof(header)) || header.magic != PROGRAM_CACHE_MAGIC || header.version != PROGRAM_CACHE_VERSION || header.key != key) {
+		return 0;
+	}
+
+	// se o tamanho do binário indicado no cabeçalho não cabe no ficheiro (cache truncada ou corrompida),
+	// não reserva a memória e volta a compilar o código
+	if (header.binaryLength == 0 || sizeof(header) + (unsigned long long)header.binaryLength > fileSize) {
+		return 0;
+	}
 
-		return -1;
+	std::vector<char> binary(header.binaryLength);
+	if (!file.read(binary.data(), binary.size())) {
+		return 0;
+	}
+
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, header.binaryFormat, binary.data(), (GLsizei)binary.size());
+
+	// o driver pode recusar o binário (por exemplo, depois de uma atualização com a mesma versão)
+	GLint linked;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (!linked) {
+		std::cerr << "Binario do programa shader recusado pelo driver; a compilar o codigo." << std::endl;
+		glDeleteProgram(program);
+		return 0;
 	}
 
 	return program;
 }
 
-#pragma endregion
\ No newline at end of file
+bool saveProgramBinary(const char* cacheFilepath, unsigned long long key, GLuint program) {
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+	// se o driver não disponibiliza o binário
+	if (length <= 0) {
+		return false;
+	}
+
+	std::vector<char> binary(length);
+	GLenum binaryFormat;
+	glGetProgramBinary(program, length, &length, &binaryFormat, binary.data());
+
+	ProgramCacheHeader header;
+	std::memset(&header, 0, sizeof(header));
+	header.magic = PROGRAM_CACHE_MAGIC;
+	header.version = PROGRAM_CACHE_VERSION;
+	header.key = key;
+	header.binaryFormat = binaryFormat;
+	header.binaryLength = (unsigned int)length;
+
+	std::ofstream file(cacheFilepath, std::ios::binary | std::ios::trunc);
+
+	// se não foi possível criar o ficheiro (por exemplo, pasta só de leitura), a cache não é usada
+	if (!file) {
+		return false;
+	}
+
+	file.write((const char*)&header, sizeof(header));
+	file.write(binary.data(), length);
+
+	return (bool)file;
+}
+
+#pragma endregion
+
+
+#pragma region funções dos handles dos uniforms
+
+template <> void Uniform<int>::set(const int& value) const {
+	glProgramUniform1i(_program, _location, value);
+}
+
+template <> void Uniform<float>::set(const float& value) const {
+	glProgramUniform1f(_program, _location, value);
+}
+
+template <> void Uniform<glm::vec3>::set(const glm::vec3& value) const {
+	glProgramUniform3fv(_program, _location, 1, &value[0]);
+}
+
+template <> void Uniform<glm::vec4>::set(const glm::vec4& value) const {
+	glProgramUniform4fv(_program, _location, 1, &value[0]);
+}
+
+template <> void Uniform<glm::mat3>::set(const glm::mat3& value) const {
+	glProgramUniformMatrix3fv(_program, _location, 1, GL_FALSE, &value[0][0]);
+}
+
+template <> void Uniform<glm::mat4>::set(const glm::mat4& value) const {
+	glProgramUniformMatrix4fv(_program, _location, 1, GL_FALSE, &value[0][0]);
+}
+
+#pragma endregion
+
+
+#pragma region funções getters da classe ShaderProgram
+
+GLuint ShaderProgram::getId() const {
+	return _program;
+}
+
+bool ShaderProgram::isValid() const {
+	return _program != 0;
+}
+
+bool ShaderProgram::isFromBinary() const {
+	return _isFromBinary;
+}
+
+int ShaderProgram::getNumberOfUniforms() const {
+	return (int)_uniforms.size();
+}
+
+int ShaderProgram::getNumberOfBlocks() const {
+	return (int)_blocks.size();
+}
+
+const BlockInfo* ShaderProgram::getBlock(const char* name) const {
+	auto block = _blocks.find(name);
+	return block != _blocks.end() ? &block->second : nullptr;
+}
+
+GLint ShaderProgram::getInputLocation(const char* name) const {
+	auto input = _inputs.find(name);
+	return input != _inputs.end() ? input->second : -1;
+}
+
+#pragma endregion
+
+
+#pragma region construtores da classe ShaderProgram
+
+ShaderProgram::ShaderProgram() {
+	_program = 0;
+	_isFromBinary = false;
+}
+
+ShaderProgram::ShaderProgram(GLuint program, bool isFromBinary) {
+	_program = program;
+	_isFromBinary = isFromBinary;
+
+	// a tabela é construída uma só vez, logo depois de linkar
+	reflect();
+}
+
+#pragma endregion
+
+
+#pragma region funções secundárias da classe ShaderProgram
+
+// verifica se um uniform do tipo GLSL pode ser atribuído por um handle de inteiros (int, bool e samplers)
+static bool isIntegerUniform(GLenum type) {
+	switch (type) {
+	case GL_INT:
+	case GL_BOOL:
+	case GL_SAMPLER_2D:
+	case GL_SAMPLER_3D:
+	case GL_SAMPLER_CUBE:
+	case GL_SAMPLER_2D_ARRAY:
+	case GL_SAMPLER_2D_SHADOW:
+	case GL_SAMPLER_BUFFER:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void ShaderProgram::reflect(void) {
+	// uniforms ativos (os que o compilador não eliminou)
+	GLint numberOfUniforms = 0;
+	glGetProgramInterfaceiv(_program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &numberOfUniforms);
+
+	const GLenum uniformProperties[] = { GL_NAME_LENGTH, GL_TYPE, GL_LOCATION, GL_ARRAY_SIZE, GL_BLOCK_INDEX };
+	std::vector<GLchar> name;
+
+	for (GLint i = 0; i < numberOfUniforms; i++) {
+		GLint values[5];
+		glGetProgramResourceiv(_program, GL_UNIFORM, i, 5, uniformProperties, 5, nullptr, values);
+
+		name.resize(values[0]);
+		glGetProgramResourceName(_program, GL_UNIFORM, i, values[0], nullptr, name.data());
+
+		UniformInfo info = { (GLenum)values[1], values[2], values[3], values[4] };
+		std::string uniformName(name.data());
+		_uniforms[uniformName] = info;
+
+		// os arrays são reportados como "nome[0]"; também ficam acessíveis só pelo nome
+		size_t bracket = uniformName.rfind("[0]");
+		if (bracket != std::string::npos && bracket + 3 == uniformName.size()) {
+			_uniforms[uniformName.substr(0, bracket)] = info;
+		}
+	}
+
+	// blocos de uniforms e de armazenamento
+	reflectBlocks(GL_UNIFORM_BLOCK);
+	reflectBlocks(GL_SHADER_STORAGE_BLOCK);
+
+	// atributos de entrada do vertex shader
+	GLint numberOfInputs = 0;
+	glGetProgramInterfaceiv(_program, GL_PROGRAM_INPUT, GL_ACTIVE_RESOURCES, &numberOfInputs);
+
+	const GLenum inputProperties[] = { GL_NAME_LENGTH, GL_LOCATION };
+
+	for (GLint i = 0; i < numberOfInputs; i++) {
+		GLint values[2];
+		glGetProgramResourceiv(_program, GL_PROGRAM_INPUT, i, 2, inputProperties, 2, nullptr, values);
+
+		name.resize(values[0]);
+		glGetProgramResourceName(_program, GL_PROGRAM_INPUT, i, values[0], nullptr, name.data());
+
+		_inputs[std::string(name.data())] = values[1];
+	}
+}
+
+void ShaderProgram::reflectBlocks(GLenum interface) {
+	GLint numberOfBlocks = 0;
+	glGetProgramInterfaceiv(_program, interface, GL_ACTIVE_RESOURCES, &numberOfBlocks);
+
+	const GLenum properties[] = { GL_NAME_LENGTH, GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+	std::vector<GLchar> name;
+
+	for (GLint i = 0; i < numberOfBlocks; i++) {
+		GLint values[3];
+		glGetProgramResourceiv(_program, interface, i, 3, properties, 3, nullptr, values);
+
+		name.resize(values[0]);
+		glGetProgramResourceName(_program, interface, i, values[0], nullptr, name.data());
+
+		_blocks[std::string(name.data())] = { interface, values[1], values[2] };
+	}
+}
+
+const UniformInfo* ShaderProgram::findUniform(const char* name, GLenum type) const {
+	auto uniform = _uniforms.find(name);
+
+	// se o uniform não existe ou foi eliminado pelo compilador, o handle fica inválido
+	// (é normal numa variante: por exemplo, a variante sem textura não usa o sampler)
+	if (uniform == _uniforms.end()) {
+		return nullptr;
+	}
+
+	// se o tipo do handle não corresponde ao tipo declarado no shader
+	const UniformInfo& info = uniform->second;
+	bool compatible = type == GL_INT ? isIntegerUniform(info.type) : info.type == type;
+	if (!compatible) {
+		std::cerr << "Uniform '" << name << "' com tipo 0x" << std::hex << info.type << std::dec << " diferente do handle." << std::endl;
+		return nullptr;
+	}
+
+	// se pertence a um bloco, não tem localização própria
+	if (info.location < 0) {
+		std::cerr << "Uniform '" << name << "' pertence a um bloco." << std::endl;
+		return nullptr;
+	}
+
+	return &info;
+}
+
+#pragma endregion
+
+
+#pragma region funções da classe ShaderVariants
+
+int ShaderVariants::getNumberOfPrograms() const {
+	return (int)_programs.size();
+}
+
+ShaderVariants::ShaderVariants() {
+}
+
+ShaderVariants::~ShaderVariants() {
+	for (auto& variant : _programs) {
+		delete variant.second;
+	}
+}
+
+void ShaderVariants::setShaders(const ShaderInfo* shaders) {
+	// copia a lista (terminada em GL_NONE), porque as variantes são compiladas mais tarde
+	_shaders.clear();
+	for (int i = 0; shaders[i].type != GL_NONE; i++) {
+		_shaders.push_back(shaders[i]);
+	}
+	_shaders.push_back({ GL_NONE, nullptr, 0 });
+}
+
+ShaderProgram* ShaderVariants::get(const char* name, const char* defines) {
+	// se a variante já foi compilada
+	auto variant = _programs.find(name);
+	if (variant != _programs.end()) {
+		return variant->second;
+	}
+
+	// compila a variante só quando é pedida pela primeira vez (ou carrega-a da cache de binários)
+	ShaderProgram program = loadShaders(_shaders.data(), defines, name);
+	if (!program.isValid()) {
+		return nullptr;
+	}
+
+	ShaderProgram* result = new ShaderProgram(program);
+	_programs[name] = result;
+
+	return result;
+}
+
+#pragma endregion
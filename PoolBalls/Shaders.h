@@ -1,7 +1,7 @@
 /*
- * @descrio	Ficheiro com todas as assinaturas relativas ao carregamento de shaders.
+ * @descrição	Ficheiro com todas as assinaturas relativas ao carregamento de shaders.
  * @ficheiro	Shaders.h
- * @autor(s)	Henrique Azevedo a23488, Lus Pereira a18446, Pedro Silva a20721, Vnia Pereira a19264
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
  * @data		11/06/2023
 */
 
@@ -11,9 +11,25 @@
 #ifndef LOAD_SHADERS_H
 #define LOAD_SHADERS_H 1
 
-#pragma region importaes
+#pragma region importações
 
-#include <GL\gl.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#define GLEW_STATIC
+#include <GL\glew.h>
+
+#include <glm\glm.hpp>
+
+#pragma endregion
+
+
+#pragma region constantes
+
+#define PROGRAM_CACHE_EXTENSION ".program"	// extensão do ficheiro com o binário do programa, junto ao executável
+#define PROGRAM_CACHE_MAGIC 0x50504250		// "PBPP"
+#define PROGRAM_CACHE_VERSION 1
 
 #pragma endregion
 
@@ -26,13 +42,144 @@ typedef struct {
 	GLuint shader;
 } ShaderInfo;
 
+// estrutura do cabeçalho do ficheiro de cache de um programa (seguido do binário devolvido pelo driver)
+typedef struct {
+	unsigned int magic;				// PROGRAM_CACHE_MAGIC
+	unsigned int version;			// PROGRAM_CACHE_VERSION
+	unsigned long long key;			// hash do código dos shaders e do driver (fabricante, renderizador e versão)
+	unsigned int binaryFormat;		// formato do binário, só válido no mesmo driver
+	unsigned int binaryLength;		// tamanho do binário, em bytes
+} ProgramCacheHeader;
+
+// estrutura de um uniform ativo do programa, obtido por reflexão depois de linkar
+typedef struct {
+	GLenum type;			// tipo GLSL (GL_FLOAT_VEC3, GL_SAMPLER_2D_ARRAY, ...)
+	GLint location;			// localização (-1 se pertence a um bloco)
+	GLint arraySize;		// número de elementos (1 se não é um array)
+	GLint blockIndex;		// índice do bloco a que pertence (-1 se não pertence a nenhum)
+} UniformInfo;
+
+// estrutura de um bloco de uniforms ou de armazenamento (SSBO) ativo do programa
+typedef struct {
+	GLenum interface;		// GL_UNIFORM_BLOCK ou GL_SHADER_STORAGE_BLOCK
+	GLint binding;			// ponto de ligação do bloco
+	GLint dataSize;			// tamanho mínimo do buffer, em bytes
+} BlockInfo;
+
+// tipo GLSL correspondente a cada tipo C++ aceite pelos handles dos uniforms
+template <typename T> struct UniformType;
+template <> struct UniformType<int> { static const GLenum value = GL_INT; };
+template <> struct UniformType<float> { static const GLenum value = GL_FLOAT; };
+template <> struct UniformType<glm::vec3> { static const GLenum value = GL_FLOAT_VEC3; };
+template <> struct UniformType<glm::vec4> { static const GLenum value = GL_FLOAT_VEC4; };
+template <> struct UniformType<glm::mat3> { static const GLenum value = GL_FLOAT_MAT3; };
+template <> struct UniformType<glm::mat4> { static const GLenum value = GL_FLOAT_MAT4; };
+
+#pragma endregion
+
+
+#pragma region classes
+
+// classe de um handle tipado para um uniform, resolvido uma só vez (um handle inválido ignora as atribuições)
+template <typename T>
+class Uniform {
+private:
+	// atributos privados
+	GLuint _program;
+	GLint _location;
+
+public:
+	// getters - obter valores de atributos fora da classe
+	GLint getLocation() const { return _location; }
+	bool isValid() const { return _location >= 0; }
+
+	// construtores
+	Uniform() : _program(0), _location(-1) {}
+	Uniform(GLuint program, GLint location) : _program(program), _location(location) {}
+
+	// principais
+	void set(const T& value) const;
+};
+
+template <> void Uniform<int>::set(const int& value) const;
+template <> void Uniform<float>::set(const float& value) const;
+template <> void Uniform<glm::vec3>::set(const glm::vec3& value) const;
+template <> void Uniform<glm::vec4>::set(const glm::vec4& value) const;
+template <> void Uniform<glm::mat3>::set(const glm::mat3& value) const;
+template <> void Uniform<glm::mat4>::set(const glm::mat4& value) const;
+
+// classe de um programa shader linkado, com a tabela de reflexão dos seus uniforms, blocos e entradas
+class ShaderProgram {
+private:
+	// atributos privados
+	GLuint _program;
+	bool _isFromBinary;		// se foi carregado da cache de binários, sem compilar
+	std::unordered_map<std::string, UniformInfo> _uniforms;
+	std::unordered_map<std::string, BlockInfo> _blocks;
+	std::unordered_map<std::string, GLint> _inputs;
+
+	// secundárias
+	void reflect(void);
+	void reflectBlocks(GLenum interface);
+	const UniformInfo* findUniform(const char* name, GLenum type) const;
+
+public:
+	// getters - obter valores de atributos fora da classe
+	GLuint getId() const;
+	bool isValid() const;
+	bool isFromBinary() const;
+	int getNumberOfUniforms() const;
+	int getNumberOfBlocks() const;
+	const BlockInfo* getBlock(const char* name) const;
+	GLint getInputLocation(const char* name) const;
+
+	// construtores
+	ShaderProgram();
+	ShaderProgram(GLuint program, bool isFromBinary = false);
+
+	// principais
+	template <typename T>
+	Uniform<T> getUniform(const char* name) const {
+		const UniformInfo* info = findUniform(name, UniformType<T>::value);
+		return info ? Uniform<T>(_program, info->location) : Uniform<T>();
+	}
+};
+
+// classe das variantes de um programa, cada uma compilada com #define diferentes (em vez de ramos no shader)
+class ShaderVariants {
+private:
+	// atributos privados
+	std::vector<ShaderInfo> _shaders;
+	std::unordered_map<std::string, ShaderProgram*> _programs;	// variantes já compiladas, pelo nome
+
+public:
+	// getters - obter valores de atributos fora da classe
+	int getNumberOfPrograms() const;
+
+	// setters - definir valores de atributos fora da classe
+	void setShaders(const ShaderInfo* shaders);
+
+	// construtor
+	ShaderVariants();
+
+	// destrutor
+	~ShaderVariants();
+
+	// principais
+	ShaderProgram* get(const char* name, const char* defines);
+};
+
 #pragma endregion
 
 
-#pragma region funes
+#pragma region funções
 
 static const GLchar* readShader(const char* filename);
-GLuint loadShaders(ShaderInfo* shaders);
+ShaderProgram loadShaders(ShaderInfo* shaders, const char* defines = nullptr, const char* variantName = nullptr);
+unsigned long long hashProgramSources(ShaderInfo* shaders, const GLchar* const* sources);
+std::string getProgramCachePath(ShaderInfo* shaders, const char* variantName);
+GLuint loadProgramBinary(const char* cacheFilepath, unsigned long long key);
+bool saveProgramBinary(const char* cacheFilepath, unsigned long long key, GLuint program);
 
 #pragma endregion
 
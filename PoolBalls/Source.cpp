@@ -21,6 +21,7 @@
 #include <vector>
 #include <string>
 #include <fstream>
+#include <atomic>
 
 #define GLEW_STATIC
 #include <GL\glew.h>
@@ -36,6 +37,12 @@
 #include "Source.h"
 #include "Shaders.h"
 #include "Pool.h"
+#include "Physics.h"
+#include "EventPhysics.h"
+#include "Scene.h"
+#include "Jobs.h"
+#include "Culling.h"
+#include "Memory.h"
 
 #pragma endregion
 
@@ -47,10 +54,39 @@ const GLuint _numberOfTableVertices = 36;
 GLfloat _tableVertices[_numberOfTableVertices * 8];
 GLuint _tableVAO;
 GLuint _tableVBO;
+Pool::BoundingSphere _tableBounds;	// esfera envolvente da mesa no espaço do objeto
 
 // bolas
-const int _numberOfBalls = 15;
+const int _numberOfBalls = NUMBER_OF_BALLS;
 Pool::RendererBall _rendererBalls[_numberOfBalls];
+Pool::InstancedRenderer _instancedRenderer;
+Pool::TextureArray _ballTextures;
+Pool::MaterialArray _ballMaterials;
+
+// dados partilhados por todos os objetos (câmara e luzes), enviados em uniform blocks
+Pool::FrameData _frameData;
+Pool::UniformBuffer _frameBuffer;
+Pool::UniformBuffer _lightsBuffer;
+
+// lista de luzes do modelo de luz LIGHT_MODEL_MULTIPLE, escolhidas por tile do ecrã em cada frame
+Pool::TiledLights _tiledLights;
+
+// bolas cujas matrizes foram recalculadas na última frame (as outras usaram as da frame anterior)
+int _numberOfTransformUpdates = 0;
+
+// tempos do arranque (em segundos), mostrados com as outras estatísticas na tecla 'c'
+double _shaderLoadTime = 0.0;
+bool _isShaderFromBinary = false;
+double _assetsLoadTime = 0.0;
+double _assetsWaitTime = 0.0;
+
+// descarte dos objetos fora da pirâmide de visão (a mesa é o objeto 0 e a bola i é o objeto i + 1)
+Pool::FrustumCuller _frustumCuller;
+
+// variantes do programa shader para o modelo de luz ativo (a mesa não tem textura, as bolas têm)
+int _lightModel = 1;
+Pool::ProgramVariant* _tableProgram = nullptr;
+Pool::ProgramVariant* _ballProgram = nullptr;
 
 // câmara
 GLfloat _angle = -10.0f;
@@ -61,10 +97,23 @@ float _lastX = 0.0f;
 float _lastY = 0.0f;
 bool _firstMouse = true;
 
+// simulação física das bolas (passo fixo ou por eventos)
+Pool::Physics _fixedStepPhysics;
+Pool::EventPhysics _eventPhysics;
+Pool::Simulation* _physics = &_fixedStepPhysics;
+double _lastFrameTime = 0.0;
+
+// renderização a pedido: só se desenha uma frame nova quando algo visível mudou
+bool _isFrameDirty = true;
+long long _numberOfFramesDrawn = 0;
+long long _numberOfFramesSkipped = 0;
+
 // animação de uma bola
 int _animatedBallIndex = 4;
 bool _animationStarted = false;
 bool _animationFinished = false;
+glm::vec3 _animatedBallVelocity = glm::vec3(0.06f, 0.0f, 0.06f);		// unidades por segundo em X e Z
+glm::vec3 _animatedBallAngularVelocity = glm::vec3(0.0f);			// efeito (radianos por segundo), somado ao rolamento calculado pela física
 
 #pragma endregion
 
@@ -112,17 +161,39 @@ int main()
 	// quando é pressionada uma tecla
 	glfwSetCharCallback(window, charCallback);
 
+	// quando o conteúdo da janela tem de ser redesenhado (por exemplo, depois de ficar tapada)
+	glfwSetWindowRefreshCallback(window, refreshCallback);
+
 	// mantém a janela aberta e atualizada
+	_lastFrameTime = glfwGetTime();
 	while (!glfwWindowShouldClose(window))
 	{
-		// renderiza os objetos na cena
-		display();
+		// avança a simulação física conforme o tempo real decorrido
+		update();
+
+		// só renderiza se a câmara, as luzes ou as bolas mudaram desde a última frame
+		if (_isFrameDirty) {
+			_isFrameDirty = false;
 
-		// troca os buffers de renderização (da frame antiga para a nova)
-		glfwSwapBuffers(window);
+			// renderiza os objetos na cena
+			display();
 
-		// processa todos os eventos ocorridos
-		glfwPollEvents();
+			// troca os buffers de renderização (da frame antiga para a nova)
+			glfwSwapBuffers(window);
+			_numberOfFramesDrawn++;
+		}
+		else {
+			_numberOfFramesSkipped++;
+		}
+
+		// com a cena em movimento (ou texturas ainda a chegar), processa os eventos ocorridos e continua;
+		// parada, bloqueia até haver um evento (ou até ao tempo limite), sem ocupar o processador
+		if (isSceneAnimating() || _ballTextures.isUploading()) {
+			glfwPollEvents();
+		}
+		else {
+			glfwWaitEventsTimeout(IDLE_WAIT_TIMEOUT);
+		}
 	}
 
 	// termina todas as instâncias da glfw
@@ -137,6 +208,28 @@ int main()
 #pragma region funções do programa
 
 void init(void) {
+	// -----------------------------------------------------------
+	// Carregar dados das bolas para CPU (em segundo plano)
+	// -----------------------------------------------------------
+
+	// disposição inicial das bolas na simulação física (partilhada com a simulação em lote)
+	Pool::loadScene(&_fixedStepPhysics);
+	Pool::loadScene(&_eventPhysics);
+
+	// cada bola é uma tarefa: interpreta o .obj e o .mtl e descodifica a imagem numa thread do sistema de tarefas
+	// (só leitura de ficheiros, sem chamadas OpenGL), enquanto a thread principal prepara a mesa e os shaders
+	double assetsStartTime = glfwGetTime();
+	Pool::TaskGroup ballAssets;
+	for (int i = 0; i < _numberOfBalls; i++) {
+		Pool::getJobSystem().submit(ballAssets, [i]() {
+			_rendererBalls[i].setId(i + 1);
+
+			std::string objFilepath = "textures/Ball" + std::to_string(i + 1) + ".obj";
+			_rendererBalls[i].Read(objFilepath);
+		});
+	}
+
+
 	// -----------------------------------------------------------
 	// Carregar dados da mesa para CPU
 	// -----------------------------------------------------------
@@ -255,6 +348,7 @@ void init(void) {
 
 	// inicializa o VBO atualmente ativo com dados imutáveis
 	glBufferStorage(GL_ARRAY_BUFFER, sizeof(_tableVertices), _tableVertices, 0);
+	Pool::trackGpuMemory(MEMORY_MESHES, sizeof(_tableVertices));
 
 	// ativar atributos das posições dos vértices
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (void*)0);
@@ -271,67 +365,9 @@ void init(void) {
 	// desvincula o VAO atual
 	glBindVertexArray(_tableVAO);
 
-
-	// -----------------------------------------------------------
-	// Carregar dados das bolas para CPU
-	// -----------------------------------------------------------
-
-	// posições das bolas
-	std::vector<glm::vec3> _positions = {
-		glm::vec3(1.1f, 0.33f, 1.1f),		// bola 1
-		glm::vec3(-1.1f, 0.33f, -1.1f),		// bola 2
-		glm::vec3(-1.1f, 0.33f, 1.1f),		// bola 3
-		glm::vec3(1.1f, 0.33f, -1.1f),		// bola 4
-		glm::vec3(0.1f, 0.33f, -0.1f),		// bola 5
-		glm::vec3(-0.3f, 0.33f, -0.3f),		// bola 6
-		glm::vec3(-0.6f, 0.33f, -0.4f),		// bola 7
-		glm::vec3(0.8f, 0.33f, 0.7f),		// bola 8
-		glm::vec3(-0.8f, 0.33f, -0.2f),		// bola 9
-		glm::vec3(0.3f, 0.33f, 0.7f),		// bola 10
-		glm::vec3(-0.2f, 0.33f, -0.8f),		// bola 11
-		glm::vec3(0.7f, 0.33f, 0.5f),		// bola 12
-		glm::vec3(-0.9f, 0.33f, 0.6f),		// bola 13
-		glm::vec3(0.1f, 0.33f, 0.3f),		// bola 14
-		glm::vec3(0.4f, 0.33f, -0.6f),		// bola 15
-	};
-
-	// rotações das bolas
-	std::vector<glm::vec3> _orientations = {
-		glm::vec3(0.0f),		// bola 1
-		glm::vec3(0.0f),		// bola 2
-		glm::vec3(0.0f),		// bola 3
-		glm::vec3(0.0f),		// bola 4
-		glm::vec3(0.0f),		// bola 5
-		glm::vec3(0.0f),		// bola 6
-		glm::vec3(0.0f),		// bola 7
-		glm::vec3(0.0f),		// bola 8
-		glm::vec3(0.0f),		// bola 9
-		glm::vec3(0.0f),		// bola 10
-		glm::vec3(0.0f),		// bola 11
-		glm::vec3(0.0f),		// bola 12
-		glm::vec3(0.0f),		// bola 13
-		glm::vec3(0.0f),		// bola 14
-		glm::vec3(0.0f),		// bola 15
-	};
-
-	// para cada bola, define um identificador único, posição e orientação,
-	// carrega o modelo, material e textura e envia os dados para a GPU,
-	for (int i = 0; i < _numberOfBalls; i++) {
-		_rendererBalls[i].setId(i + 1);
-
-		std::string objFilepath = "textures/Ball" + std::to_string(i + 1) + ".obj";
-		_rendererBalls[i].Read(objFilepath);
-
-		_rendererBalls[i].setPosition(_positions[i]);
-		_rendererBalls[i].setOrientation(_orientations[i]);
-
-
-		// -----------------------------------------------------------
-		// Enviar dados das bolas para GPU
-		// -----------------------------------------------------------
-
-		_rendererBalls[i].Send();
-	}
+	// esfera envolvente da mesa, para a descartar quando está fora da pirâmide de visão
+	_tableBounds = Pool::computeBoundingSphere(_tableVertices, _numberOfTableVertices, 8);
+	_frustumCuller.setNumberOfObjects(1 + _numberOfBalls);
 
 
 	// -----------------------------------------------------------
@@ -345,56 +381,124 @@ void init(void) {
 		{ GL_NONE, NULL }
 	};
 
-	// carrega shaders
-	Pool::_programShader = loadShaders(shaders);
+	// cada modelo de luz tem uma variante do programa, compilada quando é usada pela primeira vez
+	Pool::_programVariants.setShaders(shaders);
+
+	// matrizes de transformação (estado inicial de cada variante)
+	Pool::_modelMatrix = glm::rotate(glm::mat4(1.0f), _angle, glm::vec3(0.0f, 1.0f, 0.15f));
+	Pool::_viewMatrix = glm::lookAt(
+		_cameraPosition,				// posição da câmara
+		glm::vec3(0.0f, 0.0f, 0.0f),	// para onde está a "olhar"
+		glm::vec3(0.0f, 1.0f, 0.0f)		// orientação vertical na qual a câmera está a "olha"
+	);
+	glm::mat4 modelViewMatrix = Pool::_viewMatrix * Pool::_modelMatrix;
+	Pool::_projectionMatrix = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+	Pool::_normalMatrix = glm::inverseTranspose(glm::mat3(modelViewMatrix));
+
+	// carrega as variantes da luz padrão (do binário guardado na execução anterior, se o código e o driver não mudaram)
+	double shaderStartTime = glfwGetTime();
 
 	// se houve erros ao carregar shaders
-	if (!Pool::_programShader) {
+	if (!selectLightModel(_lightModel)) {
 		std::cout << "Erro ao carregar shaders: " << std::endl;
 		exit(EXIT_FAILURE);
 	}
 
+	_shaderLoadTime = glfwGetTime() - shaderStartTime;
+	_isShaderFromBinary = _tableProgram->program->isFromBinary();
+
 
 	// -----------------------------------------------------------
 	// Envia shaders para GPU
 	// -----------------------------------------------------------
 
-	// vincula o programa shader
-	Pool::bindProgramShader(&Pool::_programShader);
-
 	// atribui os atributos dos vértices ao programa shader
-	Pool::sendAttributesToProgramShader(&Pool::_programShader);
-
-	// matrizes de transformação
-	Pool::_modelMatrix = glm::rotate(glm::mat4(1.0f), _angle, glm::vec3(0.0f, 1.0f, 0.15f));
-	Pool::_viewMatrix = glm::lookAt(
-		_cameraPosition,				// posição da câmara
-		glm::vec3(0.0f, 0.0f, 0.0f),	// para onde está a "olhar"
-		glm::vec3(0.0f, 1.0f, 0.0f)		// orientação vertical na qual a câmera está a "olha"
-	);
-	glm::mat4 modelViewMatrix = Pool::_viewMatrix * Pool::_modelMatrix;
-	Pool::_projectionMatrix = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f);
-	Pool::_normalMatrix = glm::inverseTranspose(glm::mat3(modelViewMatrix));
-
-	// atribui as matrizes de transformação ao programa shader
-	Pool::sendUniformsToProgramShader(&Pool::_programShader, &Pool::_modelMatrix, &Pool::_viewMatrix, &modelViewMatrix, &Pool::_projectionMatrix, &Pool::_normalMatrix);
+	Pool::sendAttributesToProgramShader(_tableProgram->program);
+
+	// cria os uniform blocks da câmara e das luzes, ligados aos pontos fixos declarados nos shaders
+	_frameBuffer.create(GL_UNIFORM_BUFFER, FRAME_UNIFORM_BINDING, sizeof(Pool::FrameData));
+	_lightsBuffer.create(GL_UNIFORM_BUFFER, LIGHTS_UNIFORM_BINDING, sizeof(Pool::LightsData));
+
+	// cria a lista de luzes e o compute shader que as escolhe por tile (com o tamanho real da janela, em píxeis,
+	// que é também o do glViewport, para as tiles coincidirem com gl_FragCoord)
+	int framebufferWidth, framebufferHeight;
+	glfwGetFramebufferSize(glfwGetCurrentContext(), &framebufferWidth, &framebufferHeight);
+	if (!_tiledLights.create(framebufferWidth, framebufferHeight)) {
+		std::cout << "Erro ao carregar o compute shader das luzes: o modelo de luz " << LIGHT_MODEL_MULTIPLE << " fica desativado." << std::endl;
+	}
 
 	// carrega os diferentes tipos de luzes da cena
 	loadSceneLighting();
 
 
+	// -----------------------------------------------------------
+	// Enviar dados das bolas para GPU
+	// -----------------------------------------------------------
+
+	// espera pelas bolas que ainda estão a ser carregadas (a thread principal ajuda a executá-las)
+	double waitStartTime = glfwGetTime();
+	Pool::getJobSystem().wait(ballAssets);
+	_assetsLoadTime = glfwGetTime() - assetsStartTime;
+	_assetsWaitTime = glfwGetTime() - waitStartTime;
+
+	// todos os dados já estão em memória: as chamadas OpenGL, que têm de ser feitas na thread do contexto, seguem de uma vez
+	for (int i = 0; i < _numberOfBalls; i++) {
+		_rendererBalls[i].Send(_ballTextures, _ballMaterials);
+	}
+
+	// junta as imagens de todas as bolas numa única textura (array ou atlas, se os tamanhos forem diferentes);
+	// as camadas do array continuam a ser enviadas nas primeiras frames (update)
+	_ballTextures.Send();
+
+	// junta os materiais de todas as bolas num único buffer, indexado por instância
+	_ballMaterials.Send();
+
+
 	// -----------------------------------------------------------
 	// Configurar janela de renderização
 	// -----------------------------------------------------------
 
-	// define a janela de renderização
-	glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+	// define a janela de renderização (o framebuffer pode ter mais píxeis do que SCREEN_WIDTH x SCREEN_HEIGHT, em ecrãs de alta densidade)
+	glViewport(0, 0, framebufferWidth, framebufferHeight);
 
 	// ativa o teste de profundidade e o descarte de polígonos não observáveis
 	glEnable(GL_DEPTH_TEST);
 	glEnable(GL_CULL_FACE);
 }
 
+void update(void) {
+	// tempo real decorrido desde a última frame
+	double currentTime = glfwGetTime();
+	double frameTime = currentTime - _lastFrameTime;
+	_lastFrameTime = currentTime;
+
+	// emite as cópias das texturas das bolas já escritas no anel de envio pelas threads (sem esperar pelas outras)
+	if (_ballTextures.isUploading()) {
+		_ballTextures.Poll();
+		invalidateFrame();
+	}
+
+	// só avança a simulação enquanto a animação decorre
+	if (!_animationStarted || _animationFinished) {
+		return;
+	}
+
+	_physics->update(frameTime);
+
+	// as bolas mudaram de posição
+	invalidateFrame();
+
+	// se a bola animada colidiu com outro objeto
+	for (const Pool::Contact& contact : _physics->getContacts()) {
+		if (contact.ballA == _animatedBallIndex || contact.ballB == _animatedBallIndex) {
+			_animationStarted = false;
+			_animationFinished = true;
+			std::cout << "Colidiu com bola ou mesa." << std::endl;
+			break;
+		}
+	}
+}
+
 void display(void) {
 	// -----------------------------------------------------------
 	// Limpar buffers
@@ -405,124 +509,190 @@ void display(void) {
 
 
 	// -----------------------------------------------------------
-	// Desenhar mesa
+	// Atualizar dados da câmara
 	// -----------------------------------------------------------
 
-	// translação da mesa
-	glm::mat4 translatedModel = glm::translate(Pool::_modelMatrix, glm::vec3(0.0f, 0.0f, 0.0f));
-
-	// modelo de visualização do objeto
-	glm::mat4 modelView = Pool::_viewMatrix * translatedModel;
+	// uma só escrita no bloco FrameData (ignorada se a câmara não mudou)
+	_frameData.view = Pool::_viewMatrix;
+	_frameData.projection = Pool::_projectionMatrix;
+	_frameData.viewPosition = glm::vec4(_cameraPosition, 1.0f);
+	_frameData.lighting = _tiledLights.getLightingInfo();
+	_frameBuffer.update(&_frameData, sizeof(Pool::FrameData));
 
-	// obtém a localização do uniform
-	GLint modelViewId = glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "ModelView");
+	// escolhe as luzes de cada tile com a câmara deste frame (só no modelo que usa a lista de luzes)
+	if (_lightModel == LIGHT_MODEL_MULTIPLE) {
+		_tiledLights.Cull();
+	}
 
-	// atribui o valor ao uniform
-	glProgramUniformMatrix4fv(Pool::_programShader, modelViewId, 1, GL_FALSE, glm::value_ptr(modelView));
 
-	// define que a mesa não tem textura (valor 0)
-	GLint isRenderTexture = glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "isRenderTexture");
-	glProgramUniform1i(Pool::_programShader, isRenderTexture, 0);
+	// -----------------------------------------------------------
+	// Descartar objetos fora da pirâmide de visão
+	// -----------------------------------------------------------
 
-	GLint viewPositionLoc = glGetUniformLocation(Pool::_programShader, "viewPosition");
-	glUniform3f(viewPositionLoc, _cameraPosition.x, _cameraPosition.y, _cameraPosition.z);
+	// translação da mesa
+	glm::mat4 translatedModel = glm::translate(Pool::_modelMatrix, glm::vec3(0.0f, 0.0f, 0.0f));
+	_frustumCuller.setSphere(0, Pool::transformBoundingSphere(_tableBounds, translatedModel));
+
+	// atualiza os dados de instância e a esfera envolvente de cada bola em paralelo, com o estado interpolado da simulação física
+	// (as matrizes só são recalculadas nas bolas que se moveram, ou em todas se a câmara mudou)
+	std::atomic<int> numberOfTransformUpdates(0);
+	Pool::getJobSystem().parallelFor(0, _numberOfBalls, BALLS_PER_TASK, [&numberOfTransformUpdates](int from, int to) {
+		int updates = 0;
+		for (int i = from; i < to; i++) {
+			_rendererBalls[i].setPosition(_physics->getPosition(i));
+			_rendererBalls[i].setOrientation(_physics->getOrientation(i));
+			updates += _rendererBalls[i].updateTransform() ? 1 : 0;
+			_frustumCuller.setSphere(i + 1, _rendererBalls[i].getBounds());
+		}
+		numberOfTransformUpdates += updates;
+	});
+	_numberOfTransformUpdates = numberOfTransformUpdates;
 
-	// desenha a mesa na tela
-	glBindVertexArray(_tableVAO);
-	glDrawArrays(GL_TRIANGLES, 0, _numberOfTableVertices);
+	// testa todas as esferas de uma vez contra os planos da câmara deste frame (depois do zoom e da rotação)
+	_frustumCuller.Cull(Pool::extractFrustum(Pool::_projectionMatrix * Pool::_viewMatrix));
 
 
 	// -----------------------------------------------------------
-	// Desenhar bolas
+	// Desenhar mesa
 	// -----------------------------------------------------------
 
-	// desenha para cada bola
-	for (int i = 0; i < _numberOfBalls; i++) {
-		_rendererBalls[i].Draw(_rendererBalls[i].getPosition(), _rendererBalls[i].getOrientation());
+	if (_frustumCuller.isVisible(0)) {
+		// modelo de visualização do objeto
+		glm::mat4 modelView = Pool::_viewMatrix * translatedModel;
+
+		// a mesa usa a variante sem textura do modelo de luz ativo
+		Pool::bindProgramShader(_tableProgram->program);
+
+		// atribui o valor ao uniform
+		_tableProgram->uniforms.modelView.set(modelView);
+
+		// desenha a mesa na tela
+		glBindVertexArray(_tableVAO);
+		glDrawArrays(GL_TRIANGLES, 0, _numberOfTableVertices);
 	}
 
 
 	// -----------------------------------------------------------
-	// Animação de uma bola
+	// Desenhar bolas
 	// -----------------------------------------------------------
 
-	// se animação da bola iniciou
-	if (_animationStarted && !_animationFinished) {
-		// move a bola em X e Z
-		_rendererBalls[_animatedBallIndex].setPosition(glm::vec3(
-			_rendererBalls[_animatedBallIndex].getPosition().x + 0.001f,
-			_rendererBalls[_animatedBallIndex].getPosition().y,
-			_rendererBalls[_animatedBallIndex].getPosition().z + 0.001f
-		));
-
-		// roda a bola em X, Y e Z
-		_rendererBalls[_animatedBallIndex].setOrientation(_rendererBalls[_animatedBallIndex].getOrientation() + 2.0f);
-
-		// se colidiu com outro objeto
-		if (isColliding()) {
-			_animationStarted = false;
-			_animationFinished = true;
-			std::cout << "Colidiu com bola ou mesa." << std::endl;
+	// só as bolas visíveis são enviadas para o buffer de instâncias (e desenhadas)
+	int numberOfVisibleBalls = 0;
+	_instancedRenderer.setNumberOfInstances(_numberOfBalls);
+	for (int i = 0; i < _numberOfBalls; i++) {
+		// as bolas cujo .obj não foi carregado não têm malha para desenhar
+		if (_frustumCuller.isVisible(i + 1) && _rendererBalls[i].getMesh().isValid()) {
+			_instancedRenderer.setInstance(numberOfVisibleBalls++, _rendererBalls[i].getMesh(), _rendererBalls[i].getInstance());
 		}
 	}
+	_instancedRenderer.setNumberOfInstances(numberOfVisibleBalls);
+
+	// desenha as bolas visíveis com uma chamada por malha distinta (uma só quando todas partilham a esfera), com a variante com textura
+	Pool::bindProgramShader(_ballProgram->program);
+	_instancedRenderer.Draw(_ballTextures, _ballMaterials);
 }
 
 void loadSceneLighting(void) {
+	Pool::LightsData lights = {};
+
 	// fonte de luz ambiente
-	glProgramUniform3fv(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "ambientLight.ambient"), 1, glm::value_ptr(glm::vec3(7.0f)));
+	lights.ambientLight.ambient = glm::vec3(7.0f);
 
 	// fonte de luz direcional
-	glProgramUniform3fv(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "directionalLight.direction"), 1, glm::value_ptr(glm::vec3(1.0f, 0.0f, 0.0f)));
-	glProgramUniform3fv(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "directionalLight.ambient"), 1, glm::value_ptr(glm::vec3(4.0f)));
-	glProgramUniform3fv(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "directionalLight.diffuse"), 1, glm::value_ptr(glm::vec3(2.0f)));
-	glProgramUniform3fv(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "directionalLight.specular"), 1, glm::value_ptr(glm::vec3(1.0f)));
+	lights.directionalLight.direction = glm::vec3(1.0f, 0.0f, 0.0f);
+	lights.directionalLight.ambient = glm::vec3(4.0f);
+	lights.directionalLight.diffuse = glm::vec3(2.0f);
+	lights.directionalLight.specular = glm::vec3(1.0f);
 
 	// fonte de luz pontual 
-	glProgramUniform3fv(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "pointLight.position"), 1, glm::value_ptr(glm::vec3(1.0f, 0.0f, 0.0f)));
-	glProgramUniform3fv(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "pointLight.ambient"), 1, glm::value_ptr(glm::vec3(6.0f)));
-	glProgramUniform3fv(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "pointLight.diffuse"), 1, glm::value_ptr(glm::vec3(2.0f)));
-	glProgramUniform3fv(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "pointLight.specular"), 1, glm::value_ptr(glm::vec3(1.0f)));
-	glProgramUniform1f(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "pointLight.constant"), 1.0f);
-	glProgramUniform1f(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "pointLight.linear"), 0.06f);
-	glProgramUniform1f(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "pointLight.quadratic"), 0.02f);
+	lights.pointLight.position = glm::vec3(1.0f, 0.0f, 0.0f);
+	lights.pointLight.ambient = glm::vec3(6.0f);
+	lights.pointLight.diffuse = glm::vec3(2.0f);
+	lights.pointLight.specular = glm::vec3(1.0f);
+	lights.pointLight.constant = 1.0f;
+	lights.pointLight.linear = 0.06f;
+	lights.pointLight.quadratic = 0.02f;
 
 	// fonte de luz cónica
-	glProgramUniform3fv(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "spotLight.position"), 1, glm::value_ptr(glm::vec3(0.0f, 2.2f, 0.0f)));
-	glProgramUniform3fv(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "spotLight.direction"), 1, glm::value_ptr(glm::vec3(0.0f, -0.1f, 0.0f)));
-	glProgramUniform3fv(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "spotLight.ambient"), 1, glm::value_ptr(glm::vec3(5.0f)));
-	glProgramUniform3fv(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "spotLight.diffuse"), 1, glm::value_ptr(glm::vec3(1.0f)));
-	glProgramUniform3fv(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "spotLight.specular"), 1, glm::value_ptr(glm::vec3(1.0f)));
-	glProgramUniform1f(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "spotLight.constant"), 1.0f);
-	glProgramUniform1f(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "spotLight.linear"), 0.09f);
-	glProgramUniform1f(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "spotLight.quadratic"), 0.032f);
-	glProgramUniform1f(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "spotLight.cutOff"), glm::cos(glm::radians(20.0f)));
-	glProgramUniform1f(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "spotLight.outerCutOff"), glm::cos(glm::radians(30.0f)));
-
-	// define a luz padrão apresentada
-	glProgramUniform1i(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "lightModel"), 1);
+	lights.spotLight.position = glm::vec3(0.0f, 2.2f, 0.0f);
+	lights.spotLight.direction = glm::vec3(0.0f, -0.1f, 0.0f);
+	lights.spotLight.ambient = glm::vec3(5.0f);
+	lights.spotLight.diffuse = glm::vec3(1.0f);
+	lights.spotLight.specular = glm::vec3(1.0f);
+	lights.spotLight.constant = 1.0f;
+	lights.spotLight.linear = 0.09f;
+	lights.spotLight.quadratic = 0.032f;
+	lights.spotLight.cutOff = glm::cos(glm::radians(20.0f));
+	lights.spotLight.outerCutOff = glm::cos(glm::radians(30.0f));
+
+	// envia todas as luzes numa única escrita no bloco Lights
+	_lightsBuffer.update(&lights, sizeof(Pool::LightsData));
+	invalidateFrame();
+
+	// lista de luzes: as mesmas três fontes, mais uma fila de candeeiros de cores diferentes sobre a mesa
+	_tiledLights.addDirectionalLight(lights.directionalLight.direction, glm::vec3(0.1f), glm::vec3(0.4f), glm::vec3(0.4f));
+	_tiledLights.addPointLight(lights.pointLight.position, glm::vec3(0.1f), lights.pointLight.diffuse, lights.pointLight.specular, lights.pointLight.constant, lights.pointLight.linear, lights.pointLight.quadratic);
+	_tiledLights.addSpotLight(lights.spotLight.position, lights.spotLight.direction, glm::vec3(0.0f), lights.spotLight.diffuse, lights.spotLight.specular, lights.spotLight.constant, lights.spotLight.linear, lights.spotLight.quadratic, lights.spotLight.cutOff, lights.spotLight.outerCutOff);
+
+	const glm::vec3 lampColors[] = { glm::vec3(1.0f, 0.6f, 0.3f), glm::vec3(0.3f, 0.6f, 1.0f), glm::vec3(0.5f, 1.0f, 0.5f), glm::vec3(1.0f, 0.4f, 0.8f) };
+	for (int row = 0; row < 3; row++) {
+		for (int column = 0; column < 8; column++) {
+			glm::vec3 position = glm::vec3(-TABLE_HALF_WIDTH + (column + 0.5f) * (2.0f * TABLE_HALF_WIDTH / 8.0f), 0.6f, -TABLE_HALF_DEPTH + (row + 0.5f) * (2.0f * TABLE_HALF_DEPTH / 3.0f));
+			glm::vec3 color = lampColors[(row * 8 + column) % 4];
+			_tiledLights.addPointLight(position, glm::vec3(0.0f), 0.6f * color, 0.3f * color, 1.0f, 2.0f, 24.0f);
+		}
+	}
+
+	_tiledLights.Send();
 }
 
-bool isColliding(void) {
-	float _ballRadius = 0.08f;
+bool selectLightModel(int lightModel) {
+	// sem o compute shader das luzes, a variante da lista de luzes leria SSBOs que não foram ligados
+	if (lightModel == LIGHT_MODEL_MULTIPLE && !_tiledLights.isValid()) {
+		return false;
+	}
 
-	for (int i = 0; i < _numberOfBalls; i++) {
-		if (i != _animatedBallIndex) {
-			float distance = glm::distance(_rendererBalls[i].getPosition(), _rendererBalls[_animatedBallIndex].getPosition());
+	// troca de programa em vez de mudar um uniform: cada variante só calcula o seu modelo de luz
+	Pool::ProgramVariant* tableProgram = Pool::getProgramVariant(lightModel, false);
+	Pool::ProgramVariant* ballProgram = Pool::getProgramVariant(lightModel, true);
 
-			// se colidiu com alguma bola
-			if (distance <= 2 * _ballRadius) {
-				return true;
-			}
-		}
+	// se alguma variante não compilou, mantém as atuais
+	if (!tableProgram || !ballProgram) {
+		return false;
 	}
 
-	// se colidiu com os limites da mesa
-	if (_rendererBalls[_animatedBallIndex].getPosition().x + _ballRadius >= 1.25f || _rendererBalls[_animatedBallIndex].getPosition().x - _ballRadius <= -1.25f ||
-		_rendererBalls[_animatedBallIndex].getPosition().z + _ballRadius >= 1.25f || _rendererBalls[_animatedBallIndex].getPosition().z - _ballRadius <= -1.25f) {
-		return true;
-	}
+	_lightModel = lightModel;
+	_tableProgram = tableProgram;
+	_ballProgram = ballProgram;
+	invalidateFrame();
+
+	return true;
+}
+
+void invalidateFrame(void) {
+	// a próxima iteração do ciclo principal desenha uma frame nova
+	_isFrameDirty = true;
+}
+
+bool isSceneAnimating(void) {
+	// enquanto a animação decorre, a simulação tem de avançar em todas as frames
+	return _animationStarted && !_animationFinished;
+}
 
-	return false;
+void printStats(void) {
+	// descarte por pirâmide de visão e renderização a pedido
+	std::cout << "Descarte: " << _frustumCuller.getStats().culled << " de " << _frustumCuller.getStats().tested << " objetos fora da camara (mesa " << (_frustumCuller.isVisible(0) ? "visivel" : "descartada") << ")." << std::endl;
+	std::cout << "Transformacoes recalculadas: " << _numberOfTransformUpdates << " de " << _numberOfBalls << " bolas." << std::endl;
+	std::cout << "Frames: " << _numberOfFramesDrawn << " desenhadas, " << _numberOfFramesSkipped << " ignoradas (cena sem alteracoes)." << std::endl;
+
+	// arranque
+	std::cout << "Programa shader " << (_isShaderFromBinary ? "carregado da cache" : "compilado") << " em " << _shaderLoadTime * 1000.0 << " ms (" << _tableProgram->program->getNumberOfUniforms() << " uniforms e " << _tableProgram->program->getNumberOfBlocks() << " blocos ativos)." << std::endl;
+	std::cout << "Recursos das bolas carregados em " << _assetsLoadTime * 1000.0 << " ms (" << _assetsWaitTime * 1000.0 << " ms de espera da thread principal)." << std::endl;
+	std::cout << "Malhas carregadas: " << Pool::getMeshRegistry().getNumberOfMeshes() << " (" << Pool::getMeshRegistry().getNumberOfRequests() << " pedidos, " << Pool::getMeshRegistry().getNumberOfCacheHits() << " da cache)." << std::endl;
+	std::cout << "Texturas das bolas: " << _ballTextures.getNumberOfTextures() << (_ballTextures.isAtlas() ? " imagens num atlas." : " camadas num array.") << std::endl;
+	std::cout << "Anel de envio de texturas: " << _ballTextures.getUploadedBytes() / (1024 * 1024) << " MB enviados, " << _ballTextures.getNumberOfUploadWaits() << " esperas pela GPU." << std::endl;
+	std::cout << "Materiais das bolas: " << _ballMaterials.getNumberOfMaterials() << "." << std::endl;
+	std::cout << "Lista de luzes: " << _tiledLights.getNumberOfLights() << " luzes em " << _tiledLights.getNumberOfTiles() << " tiles." << std::endl;
 }
 
 #pragma endregion
@@ -534,6 +704,11 @@ void printErrorCallback(int code, const char* description) {
 	std::cout << description << std::endl;
 }
 
+void refreshCallback(GLFWwindow* window) {
+	// o sistema operativo perdeu o conteúdo da janela
+	invalidateFrame();
+}
+
 void scrollCallback(GLFWwindow* window, double xoffset, double yoffset)
 {
 	float zoomLevel = 1.0f;
@@ -549,6 +724,7 @@ void scrollCallback(GLFWwindow* window, double xoffset, double yoffset)
 	float zoomFactor = 1.0f + static_cast<float>(yoffset) * zoomSpeed;
 
 	Pool::_viewMatrix = glm::scale(Pool::_viewMatrix, glm::vec3(zoomFactor, zoomFactor, zoomFactor));
+	invalidateFrame();
 
 	zoomLevel += yoffset * zoomSpeed;
 	zoomLevel = std::max(minZoom, std::min(maxZoom, zoomLevel));
@@ -587,6 +763,7 @@ void mouseCallback(GLFWwindow* window, double xpos, double ypos)
 
 	// aplica rotação vertical 
 	Pool::_viewMatrix = glm::rotate(Pool::_viewMatrix, glm::radians(yOffset), right);
+	invalidateFrame();
 }
 
 void charCallback(GLFWwindow* window, unsigned int codepoint)
@@ -598,32 +775,79 @@ void charCallback(GLFWwindow* window, unsigned int codepoint)
 	{
 	case '1':
 		lightModel = 1;
-		glProgramUniform1i(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "lightModel"), lightModel);
-		std::cout << "Luz ambiente ativada." << std::endl;
+		if (selectLightModel(lightModel)) {
+			std::cout << "Luz ambiente ativada." << std::endl;
+		}
 		break;
 
 	case '2':
 		lightModel = 2;
-		glProgramUniform1i(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "lightModel"), lightModel);
-		std::cout << "Luz direcional ativada." << std::endl;
+		if (selectLightModel(lightModel)) {
+			std::cout << "Luz direcional ativada." << std::endl;
+		}
 		break;
 
 	case '3':
 		lightModel = 3;
-		glProgramUniform1i(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "lightModel"), lightModel);
-		std::cout << "Luz pontual ativada." << std::endl;
+		if (selectLightModel(lightModel)) {
+			std::cout << "Luz pontual ativada." << std::endl;
+		}
 		break;
 
 	case '4':
 		lightModel = 4;
-		glProgramUniform1i(Pool::_programShader, glGetProgramResourceLocation(Pool::_programShader, GL_UNIFORM, "lightModel"), lightModel);
-		std::cout << "Luz conica ativada." << std::endl;
+		if (selectLightModel(lightModel)) {
+			std::cout << "Luz conica ativada." << std::endl;
+		}
+		break;
+
+	case '5':
+		lightModel = LIGHT_MODEL_MULTIPLE;
+		if (selectLightModel(lightModel)) {
+			std::cout << "Lista de luzes ativada." << std::endl;
+		}
+		else {
+			std::cout << "Lista de luzes indisponivel." << std::endl;
+		}
+		break;
+
+	case 'c':
+		// estatísticas da última frame e do arranque
+		printStats();
+		break;
+
+	case 'm':
+		// memória da CPU e da GPU usada por cada categoria de recursos
+		Pool::printMemoryUsage();
+		break;
+
+	case 'e':
+		// só permite trocar o motor de simulação antes de a animação iniciar
+		if (_animationStarted || _animationFinished) {
+			std::cout << "O motor de simulacao so pode ser trocado antes da animacao." << std::endl;
+		}
+		else if (_physics == &_fixedStepPhysics) {
+			_physics = &_eventPhysics;
+			std::cout << "Simulacao por eventos ativada." << std::endl;
+		}
+		else {
+			_physics = &_fixedStepPhysics;
+			std::cout << "Simulacao com passo fixo ativada." << std::endl;
+		}
+
 		break;
 
 	case GLFW_KEY_SPACE:
 		// não permite voltar a iniciar animação, depois de iniciar uma vez e terminar
 		if (!_animationFinished) {
+			// o tempo em que o ciclo esteve à espera de eventos não conta para a simulação
+			if (!_animationStarted) {
+				_lastFrameTime = glfwGetTime();
+			}
+
 			_animationStarted = true;
+			_physics->setVelocity(_animatedBallIndex, _animatedBallVelocity);
+			_physics->setAngularVelocity(_animatedBallIndex, _animatedBallAngularVelocity);
 			std::cout << "Animacao da bola iniciada." << std::endl;
 		}
 		else {
@@ -1,7 +1,7 @@
 /*
- * @descrio	Ficheiro com todas as assinaturas relativas  aplicao em si.
+ * @descrição	Ficheiro com todas as assinaturas relativas à aplicação em si.
  * @ficheiro	Source.h
- * @autor(s)	Henrique Azevedo a23488, Lus Pereira a18446, Pedro Silva a20721, Vnia Pereira a19264
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
  * @data		11/06/2023
 */
 
@@ -11,7 +11,7 @@
 #ifndef SOURCE_H
 #define SOURCE_H 1
 
-#pragma region importaes
+#pragma region importações
 
 #include <GLFW\glfw3.h>
 
@@ -23,26 +23,33 @@
 #define SCREEN_WIDTH 800
 #define SCREEN_HEIGHT 600
 #define SCREEN_NAME "Bilhar"
+#define BALLS_PER_TASK 64		// bolas por tarefa ao calcular as transformações em paralelo
+#define IDLE_WAIT_TIMEOUT 0.5	// segundos que o ciclo principal fica à espera de eventos quando a cena está parada
 
 #pragma endregion
 
 
-#pragma region funes do programa
+#pragma region funções do programa
 
 	void init(void);
+	void update(void);
 	void display(void);
 	void loadSceneLighting(void);
-	bool isColliding(void);
+	bool selectLightModel(int lightModel);
+	void invalidateFrame(void);
+	bool isSceneAnimating(void);
+	void printStats(void);
 
 #pragma endregion
 
 
-#pragma region funes de callbacks para a biblioteca glfw
+#pragma region funções de callbacks para a biblioteca glfw
 
 	void printErrorCallback(int code, const char* description);
 	void scrollCallback(GLFWwindow* window, double xoffset, double yoffset);
 	void mouseCallback(GLFWwindow* window, double xpos, double ypos);
 	void charCallback(GLFWwindow* window, unsigned int codepoint);
+	void refreshCallback(GLFWwindow* window);
 
 #pragma endregion
 
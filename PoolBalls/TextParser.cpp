@@ -0,0 +1,186 @@
+﻿/*
+ * @descrição	Ficheiro com todo o código relativo à leitura de ficheiros de texto mapeados em memória.
+ * @ficheiro	TextParser.cpp
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+ *
+ * -------------------------------------
+ *
+ * Os ficheiros .obj e .mtl são lidos diretamente da memória mapeada, sem std::getline nem std::istringstream
+ * (que criam uma string e um stream por linha). Os números são convertidos à mão, porque strtof precisa de
+ * texto terminado em '\0' e os ficheiros mapeados não o têm: a mantissa é acumulada num inteiro e escalada
+ * uma só vez por uma potência de 10 exata, o que dá o mesmo float que strtof para os valores dos modelos.
+*/
+
+
+#pragma region importações
+
+#include <cmath>
+
+#include "TextParser.h"
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region constantes
+
+	// potências de 10 representadas exatamente em double
+	static const double EXACT_POWERS_OF_10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	static const unsigned long long MAX_MANTISSA = 100000000000000000ULL;	// 10^17: mais dígitos não cabem com precisão
+
+#pragma endregion
+
+
+#pragma region funções globais da leitura de texto
+
+	const char* skipSpaces(const char* p, const char* end) {
+		while (p < end && (*p == ' ' || *p == '\t')) {
+			p++;
+		}
+
+		return p;
+	}
+
+	const char* skipLine(const char* p, const char* end) {
+		while (p < end && *p != '\n') {
+			p++;
+		}
+
+		return p < end ? p + 1 : end;
+	}
+
+	bool matchKeyword(const char* p, const char* end, const char* keyword) {
+		while (*keyword) {
+			if (p >= end || *p != *keyword) {
+				return false;
+			}
+			p++;
+			keyword++;
+		}
+
+		// a palavra tem de terminar aqui (para "v" não aceitar "vt" ou "vn")
+		return p >= end || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n';
+	}
+
+	const char* parseFloat(const char* p, const char* end, float* value) {
+		p = skipSpaces(p, end);
+		const char* start = p;
+		bool isNegative = false;
+
+		if (p < end && (*p == '-' || *p == '+')) {
+			isNegative = *p == '-';
+			p++;
+		}
+
+		unsigned long long mantissa = 0;
+		int exponent = 0;
+		bool hasDigits = false;
+
+		// parte inteira (os dígitos que não cabem na mantissa só aumentam o expoente)
+		for (; p < end && *p >= '0' && *p <= '9'; p++) {
+			if (mantissa < MAX_MANTISSA) {
+				mantissa = mantissa * 10 + (*p - '0');
+			}
+			else {
+				exponent++;
+			}
+			hasDigits = true;
+		}
+
+		// parte decimal
+		if (p < end && *p == '.') {
+			for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+				if (mantissa < MAX_MANTISSA) {
+					mantissa = mantissa * 10 + (*p - '0');
+					exponent--;
+				}
+				hasDigits = true;
+			}
+		}
+
+		// se não há número nesta posição
+		if (!hasDigits) {
+			*value = 0.0f;
+			return start;
+		}
+
+		// expoente (só se tiver dígitos; senão o 'e' não faz parte do número)
+		if (p < end && (*p == 'e' || *p == 'E')) {
+			const char* exponentStart = p + 1;
+			bool isExponentNegative = exponentStart < end && *exponentStart == '-';
+			if (exponentStart < end && (*exponentStart == '-' || *exponentStart == '+')) {
+				exponentStart++;
+			}
+
+			if (exponentStart < end && *exponentStart >= '0' && *exponentStart <= '9') {
+				int explicitExponent = 0;
+				for (p = exponentStart; p < end && *p >= '0' && *p <= '9'; p++) {
+					explicitExponent = explicitExponent < 10000 ? explicitExponent * 10 + (*p - '0') : explicitExponent;
+				}
+				exponent += isExponentNegative ? -explicitExponent : explicitExponent;
+			}
+		}
+
+		// uma só multiplicação ou divisão por uma potência exata (arredondamento correto na maioria dos casos)
+		double result = (double)mantissa;
+		if (exponent >= 0) {
+			result *= exponent <= 22 ? EXACT_POWERS_OF_10[exponent] : std::pow(10.0, exponent);
+		}
+		else {
+			result /= -exponent <= 22 ? EXACT_POWERS_OF_10[-exponent] : std::pow(10.0, -exponent);
+		}
+
+		*value = (float)(isNegative ? -result : result);
+
+		return p;
+	}
+
+	const char* parseInt(const char* p, const char* end, int* value) {
+		p = skipSpaces(p, end);
+		const char* start = p;
+		bool isNegative = false;
+
+		if (p < end && (*p == '-' || *p == '+')) {
+			isNegative = *p == '-';
+			p++;
+		}
+
+		// se não há número nesta posição
+		if (p >= end || *p < '0' || *p > '9') {
+			*value = 0;
+			return start;
+		}
+
+		long long result = 0;
+		for (; p < end && *p >= '0' && *p <= '9'; p++) {
+			result = result < 0x7FFFFFFF ? result * 10 + (*p - '0') : result;
+		}
+
+		*value = (int)(isNegative ? -result : result);
+
+		return p;
+	}
+
+	const char* parseToken(const char* p, const char* end, const char** token, size_t* length) {
+		p = skipSpaces(p, end);
+		*token = p;
+
+		// até ao próximo espaço ou fim de linha
+		while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+			p++;
+		}
+
+		*length = (size_t)(p - *token);
+
+		return p;
+	}
+
+#pragma endregion
+
+}
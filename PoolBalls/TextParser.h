@@ -0,0 +1,38 @@
+/*
+ * @descrição	Ficheiro com todas as assinaturas relativas à leitura de ficheiros de texto mapeados em memória.
+ * @ficheiro	TextParser.h
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+*/
+
+
+#pragma once
+
+#ifndef TEXT_PARSER_H
+#define TEXT_PARSER_H 1
+
+#pragma region importações
+
+#include <cstddef>
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region declarações da leitura de texto
+
+	// funções de leitura de texto: recebem a posição atual e o fim dos dados (que não terminam em '\0')
+	// e retornam a posição a seguir ao que foi lido, sem copiar nada nem alocar memória
+	const char* skipSpaces(const char* p, const char* end);
+	const char* skipLine(const char* p, const char* end);
+	bool matchKeyword(const char* p, const char* end, const char* keyword);
+	const char* parseFloat(const char* p, const char* end, float* value);
+	const char* parseInt(const char* p, const char* end, int* value);
+	const char* parseToken(const char* p, const char* end, const char** token, size_t* length);
+
+#pragma endregion
+
+}
+
+#endif
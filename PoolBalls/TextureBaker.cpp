@@ -0,0 +1,463 @@
+﻿/*
+ * @descrição	Ficheiro com todo o código relativo à cozedura das texturas num formato pronto para a GPU.
+ * @ficheiro	TextureBaker.cpp
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+ *
+ * -------------------------------------
+ *
+ * Antes, cada arranque descodificava os JPEG das bolas com stbi_load e a GPU gerava os mipmaps com
+ * glGenerateMipmap. Agora, na primeira vez que uma imagem é usada, é descodificada uma só vez e "cozida"
+ * num ficheiro ao lado (<nome>.jpg.tex): um cabeçalho (tamanho e data da imagem de origem, formato e posição
+ * de cada nível) seguido de todos os níveis de mipmap, já no formato em que são enviados para a GPU.
+ * Nos arranques seguintes, se o cabeçalho corresponder à imagem atual, o ficheiro é mapeado em memória e
+ * os níveis são enviados diretamente, sem descodificar nada. Depois do envio, os níveis (ficheiro mapeado ou
+ * buffer cozido) são libertados com releaseTextureData; a Texture fica só com o tamanho e o formato.
+ *
+ * As imagens sem transparência são comprimidas em BC1 (DXT1): blocos de 4x4 píxeis em 8 bytes, com duas
+ * cores 5:6:5 e um índice de 2 bits por píxel para uma de 4 cores interpoladas entre elas. Ocupam 8 vezes
+ * menos do que em RGBA8, na memória da GPU e nas leituras de cada amostra. As duas cores de cada bloco são
+ * os cantos da caixa envolvente das cores do bloco (na diagonal que acompanha a variação do verde),
+ * encolhida 1/16 para dentro, como nos compressores em tempo real; a qualidade chega para as bolas.
+*/
+
+
+#pragma region importações
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cmath>
+#include <climits>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#define GLEW_STATIC
+#include <GL\glew.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "thirdParty/StbImage.h"
+
+#include "MappedFile.h"
+#include "Memory.h"
+#include "Textures.h"
+#include "TextureBaker.h"
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region funções auxiliares da cozedura
+
+	// converte uma cor de 8 bits por canal para 5:6:5, arredondada
+	static unsigned short packRgb565(int r, int g, int b) {
+		return (unsigned short)((((r * 31 + 127) / 255) << 11) | (((g * 63 + 127) / 255) << 5) | ((b * 31 + 127) / 255));
+	}
+
+	// converte uma cor 5:6:5 para 8 bits por canal (replicando os bits mais altos nos mais baixos)
+	static void unpackRgb565(unsigned short color, int* rgb) {
+		int r = (color >> 11) & 31;
+		int g = (color >> 5) & 63;
+		int b = color & 31;
+
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+	}
+
+	static void compressBc1Block(const unsigned char* pixels, unsigned char* block) {
+		int minimum[3] = { 255, 255, 255 };
+		int maximum[3] = { 0, 0, 0 };
+
+		// caixa envolvente das cores do bloco
+		for (int i = 0; i < 16; i++) {
+			for (int c = 0; c < 3; c++) {
+				minimum[c] = std::min(minimum[c], (int)pixels[i * 4 + c]);
+				maximum[c] = std::max(maximum[c], (int)pixels[i * 4 + c]);
+			}
+		}
+
+		// escolhe a diagonal da caixa: se o vermelho ou o azul variam ao contrário do verde, troca os seus extremos
+		int center[3] = { (minimum[0] + maximum[0]) / 2, (minimum[1] + maximum[1]) / 2, (minimum[2] + maximum[2]) / 2 };
+		int redCovariance = 0, blueCovariance = 0;
+		for (int i = 0; i < 16; i++) {
+			int green = pixels[i * 4 + 1] - center[1];
+			redCovariance += (pixels[i * 4] - center[0]) * green;
+			blueCovariance += (pixels[i * 4 + 2] - center[2]) * green;
+		}
+		if (redCovariance < 0) {
+			std::swap(minimum[0], maximum[0]);
+		}
+		if (blueCovariance < 0) {
+			std::swap(minimum[2], maximum[2]);
+		}
+
+		// encolhe a caixa 1/16 para dentro (os extremos raramente são as cores mais representativas do bloco)
+		for (int c = 0; c < 3; c++) {
+			int inset = (maximum[c] - minimum[c]) / 16;
+			maximum[c] -= inset;
+			minimum[c] += inset;
+		}
+
+		unsigned short color0 = packRgb565(maximum[0], maximum[1], maximum[2]);
+		unsigned short color1 = packRgb565(minimum[0], minimum[1], minimum[2]);
+
+		// color0 > color1 indica o modo de 4 cores (sem transparência)
+		if (color0 < color1) {
+			std::swap(color0, color1);
+		}
+
+		// índice de cada píxel para a cor mais próxima (se as duas cores são iguais, todos usam a primeira)
+		unsigned int indices = 0;
+		if (color0 != color1) {
+			int palette[4][3];
+			unpackRgb565(color0, palette[0]);
+			unpackRgb565(color1, palette[1]);
+			for (int c = 0; c < 3; c++) {
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			for (int i = 0; i < 16; i++) {
+				int best = 0;
+				int bestDistance = INT_MAX;
+
+				for (int k = 0; k < 4; k++) {
+					int dr = pixels[i * 4] - palette[k][0];
+					int dg = pixels[i * 4 + 1] - palette[k][1];
+					int db = pixels[i * 4 + 2] - palette[k][2];
+					int distance = dr * dr + dg * dg + db * db;
+
+					if (distance < bestDistance) {
+						best = k;
+						bestDistance = distance;
+					}
+				}
+
+				indices |= (unsigned int)best << (2 * i);
+			}
+		}
+
+		// as duas cores e os índices, em little-endian
+		block[0] = (unsigned char)(color0 & 0xFF);
+		block[1] = (unsigned char)(color0 >> 8);
+		block[2] = (unsigned char)(color1 & 0xFF);
+		block[3] = (unsigned char)(color1 >> 8);
+		block[4] = (unsigned char)(indices & 0xFF);
+		block[5] = (unsigned char)((indices >> 8) & 0xFF);
+		block[6] = (unsigned char)((indices >> 16) & 0xFF);
+		block[7] = (unsigned char)(indices >> 24);
+	}
+
+	// textura com os níveis de um ficheiro cozido (mapeado ou ainda em memória), sem cópias
+	static Texture* createTexture(const unsigned char* data) {
+		const TextureBakeHeader* header = (const TextureBakeHeader*)data;
+		Texture* texture = new Texture;
+
+		texture->width = (int)header->width;
+		texture->height = (int)header->height;
+		texture->nChannels = header->format == GL_RGBA8 ? 4 : 3;
+		texture->format = header->format;
+		texture->numberOfLevels = (int)header->numberOfLevels;
+		for (int level = 0; level < texture->numberOfLevels; level++) {
+			texture->levels[level] = data + header->levelOffsets[level];
+			texture->levelSizes[level] = (size_t)header->levelSizes[level];
+		}
+		texture->image = header->format == GL_RGBA8 ? texture->levels[0] : nullptr;
+		texture->bakedFile = nullptr;
+		texture->bakedData = nullptr;
+
+		return texture;
+	}
+
+#pragma endregion
+
+
+#pragma region funções globais da cozedura de texturas
+
+	Texture* loadBakedTexture(const char* imageFilepath) {
+		std::string bakedFilepath = std::string(imageFilepath) + TEXTURE_BAKE_EXTENSION;
+
+		// se existe um ficheiro cozido válido, os níveis ficam no ficheiro mapeado e a imagem não é descodificada
+		MappedFile* file = new MappedFile;
+		if (openBakedTexture(bakedFilepath.c_str(), imageFilepath, file)) {
+			Texture* texture = createTexture(file->getData());
+			texture->bakedFile = file;
+			trackCpuMemory(MEMORY_TEXTURES, (long long)file->getSize());
+			return texture;
+		}
+		delete file;
+
+		// senão, descodifica e coze a imagem, e guarda o resultado para os próximos arranques
+		std::vector<unsigned char>* data = new std::vector<unsigned char>;
+		if (!bakeTexture(imageFilepath, data)) {
+			delete data;
+			return nullptr;
+		}
+		writeBakedTexture(bakedFilepath.c_str(), *data);
+
+		Texture* texture = createTexture(data->data());
+		texture->bakedData = data;
+		trackCpuMemory(MEMORY_TEXTURES, (long long)data->size());
+
+		return texture;
+	}
+
+	void releaseTextureData(Texture* texture) {
+		// os níveis pertencem ao ficheiro mapeado ou ao buffer cozido neste arranque
+		if (texture->bakedFile) {
+			trackCpuMemory(MEMORY_TEXTURES, -(long long)texture->bakedFile->getSize());
+			delete texture->bakedFile;
+			texture->bakedFile = nullptr;
+		}
+		if (texture->bakedData) {
+			trackCpuMemory(MEMORY_TEXTURES, -(long long)texture->bakedData->size());
+			delete texture->bakedData;
+			texture->bakedData = nullptr;
+		}
+
+		// o tamanho, o formato e o tamanho de cada nível continuam válidos (para comparar com outras imagens)
+		texture->image = nullptr;
+		for (int level = 0; level < texture->numberOfLevels; level++) {
+			texture->levels[level] = nullptr;
+		}
+	}
+
+	void deleteTexture(Texture* texture) {
+		if (!texture) {
+			return;
+		}
+
+		releaseTextureData(texture);
+		delete texture;
+	}
+
+	const TextureBakeHeader* openBakedTexture(const char* bakedFilepath, const char* imageFilepath, MappedFile* file) {
+		long long sourceSize, sourceTime;
+
+		// se a imagem ou o ficheiro cozido não existem
+		if (!getFileInfo(imageFilepath, &sourceSize, &sourceTime) || !file->open(bakedFilepath)) {
+			return nullptr;
+		}
+
+		const TextureBakeHeader* header = (const TextureBakeHeader*)file->getData();
+		size_t fileSize = file->getSize();
+		bool isValid = fileSize >= sizeof(TextureBakeHeader)
+			&& header->magic == TEXTURE_BAKE_MAGIC
+			&& header->version == TEXTURE_BAKE_VERSION
+			&& header->sourceSize == sourceSize
+			&& header->sourceTime == sourceTime
+			&& header->width > 0 && header->height > 0
+			&& (header->format == GL_RGBA8 || (header->format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT && GLEW_EXT_texture_compression_s3tc))
+			&& header->numberOfLevels >= 1 && header->numberOfLevels <= TEXTURE_MAX_LEVELS;
+
+		// confirma o tamanho de cada nível e que todos cabem no ficheiro (ficheiro truncado)
+		for (unsigned int level = 0; isValid && level < header->numberOfLevels; level++) {
+			int width = std::max(1, (int)(header->width >> level));
+			int height = std::max(1, (int)(header->height >> level));
+			isValid = header->levelSizes[level] == getLevelSize(header->format, width, height)
+				&& header->levelOffsets[level] + header->levelSizes[level] <= fileSize;
+		}
+
+		// se o ficheiro é de outra versão, a imagem foi alterada depois de ser cozida ou o formato não é suportado
+		if (!isValid) {
+			file->close();
+			return nullptr;
+		}
+
+		return header;
+	}
+
+	bool bakeTexture(const char* imageFilepath, std::vector<unsigned char>* data) {
+		TextureBakeHeader header;
+		std::memset(&header, 0, sizeof(header));
+
+		// se não é possível guardar a origem
+		if (!getFileInfo(imageFilepath, &header.sourceSize, &header.sourceTime)) {
+			return false;
+		}
+
+		// descodifica sempre para RGBA (os mipmaps e a compressão trabalham com 4 canais)
+		int width, height, nChannels;
+		unsigned char* image = stbi_load(imageFilepath, &width, &height, &nChannels, 4);
+
+		// se houve erros ao descodificar a imagem
+		if (!image) {
+			return false;
+		}
+
+		// as imagens com transparência ficam em RGBA8 (BC1 só tem transparência de 1 bit)
+		GLenum format = GL_RGBA8;
+		if (TEXTURE_BAKE_BC1 && nChannels != 2 && nChannels != 4 && GLEW_EXT_texture_compression_s3tc) {
+			format = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		}
+
+		int numberOfLevels = std::min((int)std::floor(std::log2((float)std::max(width, height))) + 1, TEXTURE_MAX_LEVELS);
+
+		header.magic = TEXTURE_BAKE_MAGIC;
+		header.version = TEXTURE_BAKE_VERSION;
+		header.width = (unsigned int)width;
+		header.height = (unsigned int)height;
+		header.format = format;
+		header.numberOfLevels = (unsigned int)numberOfLevels;
+
+		// posição de cada nível no ficheiro
+		size_t offset = sizeof(TextureBakeHeader);
+		for (int level = 0; level < numberOfLevels; level++) {
+			offset = (offset + TEXTURE_BAKE_ALIGNMENT - 1) & ~(size_t)(TEXTURE_BAKE_ALIGNMENT - 1);
+			header.levelOffsets[level] = offset;
+			header.levelSizes[level] = getLevelSize(format, std::max(1, width >> level), std::max(1, height >> level));
+			offset += (size_t)header.levelSizes[level];
+		}
+
+		data->assign(offset, 0);
+		std::memcpy(data->data(), &header, sizeof(header));
+
+		// cada nível é a média de 2x2 píxeis do anterior (como glGenerateMipmap), e só depois é comprimido
+		std::vector<unsigned char> current(image, image + (size_t)width * height * 4);
+		std::vector<unsigned char> next;
+		stbi_image_free(image);
+
+		for (int level = 0; level < numberOfLevels; level++) {
+			int levelWidth = std::max(1, width >> level);
+			int levelHeight = std::max(1, height >> level);
+			unsigned char* target = data->data() + header.levelOffsets[level];
+
+			if (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT) {
+				compressBc1(current.data(), levelWidth, levelHeight, target);
+			}
+			else {
+				std::memcpy(target, current.data(), (size_t)header.levelSizes[level]);
+			}
+
+			if (level + 1 < numberOfLevels) {
+				next.resize((size_t)std::max(1, levelWidth / 2) * std::max(1, levelHeight / 2) * 4);
+				downsampleLevel(current.data(), levelWidth, levelHeight, next.data());
+				current.swap(next);
+			}
+		}
+
+		return true;
+	}
+
+	bool writeBakedTexture(const char* bakedFilepath, const std::vector<unsigned char>& data) {
+		std::ofstream file(bakedFilepath, std::ios::binary | std::ios::trunc);
+
+		// se não foi possível criar o ficheiro (por exemplo, pasta só de leitura), a imagem é cozida em cada arranque
+		if (!file) {
+			return false;
+		}
+
+		file.write((const char*)data.data(), data.size());
+
+		return (bool)file;
+	}
+
+	size_t getLevelSize(GLenum format, int width, int height) {
+		// BC1: um bloco por cada 4x4 píxeis (os blocos das bordas são completados)
+		if (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT) {
+			return (size_t)((width + 3) / 4) * ((height + 3) / 4) * BC1_BLOCK_SIZE;
+		}
+
+		return (size_t)width * height * 4;
+	}
+
+#pragma endregion
+
+
+#pragma region kernels da cozedura
+
+	void downsampleLevel(const unsigned char* source, int width, int height, unsigned char* target) {
+		int targetWidth = std::max(1, width / 2);
+		int targetHeight = std::max(1, height / 2);
+
+		for (int y = 0; y < targetHeight; y++) {
+			// nas imagens com 1 píxel de altura ou largura, o mesmo píxel é usado duas vezes
+			const unsigned char* row0 = source + (size_t)std::min(2 * y, height - 1) * width * 4;
+			const unsigned char* row1 = source + (size_t)std::min(2 * y + 1, height - 1) * width * 4;
+
+			for (int x = 0; x < targetWidth; x++) {
+				int x0 = std::min(2 * x, width - 1) * 4;
+				int x1 = std::min(2 * x + 1, width - 1) * 4;
+				unsigned char* pixel = target + ((size_t)y * targetWidth + x) * 4;
+
+				for (int c = 0; c < 4; c++) {
+					pixel[c] = (unsigned char)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+				}
+			}
+		}
+	}
+
+	void compressBc1(const unsigned char* source, int width, int height, unsigned char* blocks) {
+		int blocksX = (width + 3) / 4;
+		int blocksY = (height + 3) / 4;
+		unsigned char pixels[16 * 4];
+
+		for (int by = 0; by < blocksY; by++) {
+			for (int bx = 0; bx < blocksX; bx++) {
+				// copia os 4x4 píxeis do bloco (nas bordas, repete o último píxel da imagem)
+				for (int i = 0; i < 16; i++) {
+					int x = std::min(bx * 4 + (i & 3), width - 1);
+					int y = std::min(by * 4 + (i >> 2), height - 1);
+					std::memcpy(pixels + i * 4, source + ((size_t)y * width + x) * 4, 4);
+				}
+
+				compressBc1Block(pixels, blocks + ((size_t)by * blocksX + bx) * BC1_BLOCK_SIZE);
+			}
+		}
+	}
+
+	void decompressBc1(const unsigned char* blocks, int width, int height, unsigned char* target) {
+		int blocksX = (width + 3) / 4;
+		int blocksY = (height + 3) / 4;
+
+		for (int by = 0; by < blocksY; by++) {
+			for (int bx = 0; bx < blocksX; bx++) {
+				const unsigned char* block = blocks + ((size_t)by * blocksX + bx) * BC1_BLOCK_SIZE;
+				unsigned short color0 = (unsigned short)(block[0] | (block[1] << 8));
+				unsigned short color1 = (unsigned short)(block[2] | (block[3] << 8));
+				unsigned int indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((unsigned int)block[7] << 24);
+
+				// 4 cores se color0 > color1; senão 3 cores e preto transparente
+				int palette[4][4];
+				unpackRgb565(color0, palette[0]);
+				unpackRgb565(color1, palette[1]);
+				palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+				for (int c = 0; c < 3; c++) {
+					if (color0 > color1) {
+						palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+						palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+					}
+					else {
+						palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+						palette[3][c] = 0;
+					}
+				}
+				if (color0 <= color1) {
+					palette[3][3] = 0;
+				}
+
+				for (int i = 0; i < 16; i++) {
+					int x = bx * 4 + (i & 3);
+					int y = by * 4 + (i >> 2);
+
+					// píxeis do bloco fora da imagem
+					if (x >= width || y >= height) {
+						continue;
+					}
+
+					const int* color = palette[(indices >> (2 * i)) & 3];
+					unsigned char* pixel = target + ((size_t)y * width + x) * 4;
+					for (int c = 0; c < 4; c++) {
+						pixel[c] = (unsigned char)color[c];
+					}
+				}
+			}
+		}
+	}
+
+#pragma endregion
+
+}
@@ -0,0 +1,76 @@
+/*
+ * @descrição	Ficheiro com todas as assinaturas relativas à cozedura das texturas num formato pronto para a GPU.
+ * @ficheiro	TextureBaker.h
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+*/
+
+
+#pragma once
+
+#ifndef TEXTURE_BAKER_H
+#define TEXTURE_BAKER_H 1
+
+#pragma region importações
+
+#include <vector>
+
+#define GLEW_STATIC
+#include <GL\glew.h>
+
+#include "MappedFile.h"
+#include "Memory.h"
+#include "Textures.h"
+
+#pragma endregion
+
+
+#pragma region constantes
+
+#define TEXTURE_BAKE_EXTENSION ".tex"	// extensão do ficheiro cozido, acrescentada ao nome da imagem
+#define TEXTURE_BAKE_MAGIC 0x58544250	// "PBTX"
+#define TEXTURE_BAKE_VERSION 1
+#define TEXTURE_BAKE_ALIGNMENT 16		// alinhamento de cada nível de mipmap dentro do ficheiro
+#define TEXTURE_BAKE_BC1 1				// comprime em BC1 as imagens sem transparência (8 vezes menos memória do que RGBA8)
+#define BC1_BLOCK_SIZE 8				// bytes de cada bloco de 4x4 píxeis em BC1
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region declarações da cozedura de texturas
+
+	// estrutura do cabeçalho do ficheiro de uma textura cozida (seguido dos níveis de mipmap, já no formato da GPU)
+	typedef struct {
+		unsigned int magic;								// TEXTURE_BAKE_MAGIC
+		unsigned int version;							// TEXTURE_BAKE_VERSION
+		long long sourceSize;							// tamanho da imagem de origem quando foi cozida
+		long long sourceTime;							// data de modificação da imagem de origem
+		unsigned int width;								// largura do nível 0
+		unsigned int height;							// altura do nível 0
+		unsigned int format;							// GL_RGBA8 ou GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+		unsigned int numberOfLevels;
+		unsigned long long levelOffsets[TEXTURE_MAX_LEVELS];	// posição de cada nível no ficheiro
+		unsigned long long levelSizes[TEXTURE_MAX_LEVELS];		// bytes de cada nível
+	} TextureBakeHeader;
+
+	// funções globais da cozedura de texturas
+	Texture* loadBakedTexture(const char* imageFilepath);
+	void releaseTextureData(Texture* texture);
+	void deleteTexture(Texture* texture);
+	const TextureBakeHeader* openBakedTexture(const char* bakedFilepath, const char* imageFilepath, MappedFile* file);
+	bool bakeTexture(const char* imageFilepath, std::vector<unsigned char>* data);
+	bool writeBakedTexture(const char* bakedFilepath, const std::vector<unsigned char>& data);
+	size_t getLevelSize(GLenum format, int width, int height);
+
+	// kernels da cozedura (imagens RGBA de 8 bits por canal)
+	void downsampleLevel(const unsigned char* source, int width, int height, unsigned char* target);
+	void compressBc1(const unsigned char* source, int width, int height, unsigned char* blocks);
+	void decompressBc1(const unsigned char* blocks, int width, int height, unsigned char* target);
+
+#pragma endregion
+
+}
+
+#endif
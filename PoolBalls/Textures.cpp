@@ -0,0 +1,689 @@
+﻿/*
+ * @descrição	Ficheiro com todo o código relativo ao agrupamento das texturas numa única textura.
+ * @ficheiro	Textures.cpp
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+ *
+ * -------------------------------------
+ *
+ * Antes, cada bola tinha a sua textura numa unidade de textura própria, o que limitava o número de bolas
+ * ao número de unidades do hardware. Agora todas as imagens ficam numa única textura GL_TEXTURE_2D_ARRAY,
+ * ligada uma vez por frame, e cada instância indica qual a imagem a usar (TextureSlot).
+ *
+ * Se as imagens têm todas o mesmo tamanho, cada uma ocupa uma camada do array. Caso contrário, são
+ * arrumadas lado a lado, em prateleiras, num atlas com uma só camada; cada imagem tem uma margem
+ * preenchida com os píxeis da borda, para a filtragem e os mipmaps não misturarem imagens vizinhas.
+ * Se as prateleiras passam GL_MAX_TEXTURE_SIZE, continuam em novas camadas do mesmo array.
+ *
+ * As imagens chegam já cozidas (TextureBaker.cpp), com todos os níveis de mipmap no formato da GPU (RGBA8
+ * ou BC1). No array, cada nível de cada camada é enviado tal como está, sem glGenerateMipmap. O atlas é
+ * montado a partir do nível 0 de cada imagem (descomprimido, se preciso) e os seus mipmaps são gerados pela GPU.
+ * Depois de enviadas, as imagens deixam de ocupar memória da CPU (releaseTextureData).
+ *
+ * As camadas são enviadas por um anel de pixel unpack buffers mapeado de forma persistente (UploadRing):
+ * a thread do OpenGL reserva uma região para cada imagem, as threads do sistema de tarefas copiam os píxeis
+ * diretamente para a memória mapeada e a thread do OpenGL só emite as cópias (glTexSubImage3D a partir do
+ * buffer, executadas pela GPU sem bloquear). A thread do OpenGL não espera pelas threads: em cada frame (Poll)
+ * emite as cópias dos lotes já escritos e reserva os níveis seguintes nos segmentos que a GPU já leu.
+ * Uma fence por segmento impede que um segmento seja reescrito antes de a GPU o ler.
+*/
+
+
+#pragma region importações
+
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#define GLEW_STATIC
+#include <GL\glew.h>
+
+#define GLFW_USE_DWM_SWAP_INTERVAL
+#include <GLFW\glfw3.h>
+
+#include <glm\glm.hpp>
+
+#include "Jobs.h"
+#include "Memory.h"
+#include "Textures.h"
+#include "TextureBaker.h"
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region funções getters da classe UploadRing
+
+	GLuint UploadRing::getBuffer() const {
+		return _buffer;
+	}
+
+	size_t UploadRing::getSegmentSize() const {
+		return _segmentSize;
+	}
+
+	int UploadRing::getSegment(size_t offset) const {
+		return (int)(offset / _segmentSize);
+	}
+
+	unsigned char* UploadRing::getData() const {
+		return _data;
+	}
+
+	bool UploadRing::isValid() const {
+		return _data != nullptr;
+	}
+
+	long long UploadRing::getNumberOfWaits() const {
+		return _numberOfWaits;
+	}
+
+	long long UploadRing::getUploadedBytes() const {
+		return _uploadedBytes;
+	}
+
+#pragma endregion
+
+
+#pragma region construtor e destrutor da classe UploadRing
+
+	UploadRing::UploadRing() {
+		_buffer = 0;
+		_data = nullptr;
+		_segmentSize = 0;
+		_numberOfSegments = 0;
+		_segment = 0;
+		_offset = 0;
+		_numberOfWaits = 0;
+		_uploadedBytes = 0;
+	}
+
+	UploadRing::~UploadRing() {
+		destroy();
+	}
+
+#pragma endregion
+
+
+#pragma region funções principais da classe UploadRing
+
+	bool UploadRing::create(size_t segmentSize, int numberOfSegments) {
+		// são precisos pelo menos dois segmentos, para um ser escrito enquanto o outro é lido
+		if (numberOfSegments < 2) {
+			return false;
+		}
+
+		// se o anel já existe, é substituído por um com o novo tamanho
+		destroy();
+
+		_segmentSize = segmentSize;
+		_numberOfSegments = numberOfSegments;
+		_segment = 0;
+		_offset = 0;
+		_fences.assign(numberOfSegments, nullptr);
+		_pendingRegions.assign(numberOfSegments, 0);
+
+		// buffer imutável, mapeado uma só vez e para sempre (as escritas ficam visíveis à GPU sem flush)
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glGenBuffers(1, &_buffer);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffer);
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, segmentSize * numberOfSegments, nullptr, flags);
+		_data = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, segmentSize * numberOfSegments, flags);
+
+		// o buffer só fica ligado enquanto as cópias são emitidas (as outras texturas são enviadas da memória do cliente)
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		// se o driver não suporta buffers persistentes
+		if (!_data) {
+			std::cerr << "Erro ao mapear o anel de envio de texturas: as imagens são enviadas da memória do cliente." << std::endl;
+			glDeleteBuffers(1, &_buffer);
+			_buffer = 0;
+			return false;
+		}
+
+		trackGpuMemory(MEMORY_UPLOAD, (long long)(segmentSize * numberOfSegments));
+
+		return true;
+	}
+
+	void UploadRing::destroy(void) {
+		// os objetos só podem ser apagados enquanto existir um contexto OpenGL
+		if (!_buffer || !glfwGetCurrentContext()) {
+			return;
+		}
+
+		trackGpuMemory(MEMORY_UPLOAD, -(long long)(_segmentSize * _numberOfSegments));
+
+		for (GLsync fence : _fences) {
+			if (fence) {
+				glDeleteSync(fence);
+			}
+		}
+		_fences.clear();
+		_pendingRegions.clear();
+
+		// as cópias já emitidas continuam válidas: o OpenGL só apaga o buffer depois de a GPU o ler
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		glDeleteBuffers(1, &_buffer);
+
+		_buffer = 0;
+		_data = nullptr;
+		_segmentSize = 0;
+		_numberOfSegments = 0;
+	}
+
+	bool UploadRing::allocate(size_t size, size_t* offset) {
+		// se a imagem não cabe num segmento vazio
+		if (size > _segmentSize) {
+			return false;
+		}
+
+		size_t start = (_offset + UPLOAD_RING_ALIGNMENT - 1) & ~(size_t)(UPLOAD_RING_ALIGNMENT - 1);
+
+		// se não cabe no resto do segmento atual, passa para o seguinte
+		if (start + size > _segmentSize) {
+			int next = (_segment + 1) % _numberOfSegments;
+
+			// se o seguinte tem regiões cujas cópias ainda não foram emitidas, ou a GPU ainda o está a ler,
+			// a reserva fica para mais tarde (sem bloquear a thread do OpenGL)
+			if (_pendingRegions[next] > 0 || !isSegmentFree(next)) {
+				return false;
+			}
+
+			_segment = next;
+			start = 0;
+		}
+
+		_pendingRegions[_segment]++;
+		_offset = start + size;
+		_uploadedBytes += size;
+		*offset = (size_t)_segment * _segmentSize + start;
+
+		return true;
+	}
+
+	void UploadRing::fence(int segment, int numberOfRegions) {
+		// as cópias destas regiões do segmento já foram emitidas: a fence nova cobre-as (e às anteriores)
+		if (_fences[segment]) {
+			glDeleteSync(_fences[segment]);
+		}
+
+		_fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		_pendingRegions[segment] -= numberOfRegions;
+	}
+
+#pragma endregion
+
+
+#pragma region funções secundárias da classe UploadRing
+
+	bool UploadRing::isSegmentFree(int segment) {
+		// se o segmento nunca foi lido pela GPU
+		if (!_fences[segment]) {
+			return true;
+		}
+
+		// se a GPU ainda não acabou de ler o segmento (conta as vezes em que foi preciso adiar uma reserva)
+		if (glClientWaitSync(_fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED) {
+			_numberOfWaits++;
+			return false;
+		}
+
+		glDeleteSync(_fences[segment]);
+		_fences[segment] = nullptr;
+
+		return true;
+	}
+
+#pragma endregion
+
+
+#pragma region funções getters da classe TextureArray
+
+	int TextureArray::getNumberOfTextures() const {
+		return (int)_textures.size();
+	}
+
+	const TextureSlot& TextureArray::getSlot(int index) const {
+		return _slots[index];
+	}
+
+	bool TextureArray::isAtlas() const {
+		return _isAtlas;
+	}
+
+	bool TextureArray::isUploading() const {
+		return !_uploadLevels.empty();
+	}
+
+	long long TextureArray::getUploadedBytes() const {
+		return _uploadRing.getUploadedBytes();
+	}
+
+	long long TextureArray::getNumberOfUploadWaits() const {
+		return _uploadRing.getNumberOfWaits();
+	}
+
+#pragma endregion
+
+
+#pragma region construtor e destrutor da classe TextureArray
+
+	TextureArray::TextureArray() {
+		_texture = 0;
+		_slotBuffer = 0;
+		_isAtlas = false;
+		_gpuBytes = 0;
+		_nextUploadLevel = 0;
+	}
+
+	TextureArray::~TextureArray() {
+		// as threads ainda podem estar a escrever na memória mapeada do anel
+		for (UploadBatch* batch : _uploadBatches) {
+			getJobSystem().wait(batch->copies);
+			delete batch;
+		}
+
+		// os objetos só podem ser apagados enquanto existir um contexto OpenGL
+		if (glfwGetCurrentContext()) {
+			trackGpuMemory(MEMORY_TEXTURES, -_gpuBytes);
+
+			if (_texture) {
+				glDeleteTextures(1, &_texture);
+			}
+			if (_slotBuffer) {
+				glDeleteBuffers(1, &_slotBuffer);
+			}
+
+			_uploadRing.destroy();
+		}
+	}
+
+#pragma endregion
+
+
+#pragma region funções principais da classe TextureArray
+
+	int TextureArray::add(Texture* texture) {
+		// se a imagem não foi carregada, o objeto é desenhado sem textura
+		if (!texture || texture->numberOfLevels == 0) {
+			return -1;
+		}
+
+		_textures.push_back(texture);
+
+		return (int)_textures.size() - 1;
+	}
+
+	bool TextureArray::Send(void) {
+		// se não há imagens para enviar
+		if (_textures.empty()) {
+			return false;
+		}
+
+		// verifica se as imagens têm todas o mesmo tamanho e formato
+		_isAtlas = false;
+		for (Texture* texture : _textures) {
+			if (texture->width != _textures[0]->width || texture->height != _textures[0]->height || texture->format != _textures[0]->format) {
+				_isAtlas = true;
+				break;
+			}
+		}
+
+		// gera o nome para a textura e vincula-a ao target GL_TEXTURE_2D_ARRAY da unidade das bolas
+		glGenTextures(1, &_texture);
+		glActiveTexture(GL_TEXTURE0 + BALL_TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, _texture);
+
+		// as linhas dos níveis mais pequenos não estão alinhadas a 4 bytes
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		// se as imagens não cabem no atlas, as bolas ficam com uma imagem branca (em vez de um erro do OpenGL
+		// e de o shader ler uma textura e um SSBO que não existem)
+		bool isSent = true;
+		if (_isAtlas) {
+			isSent = sendAtlas();
+			if (!isSent) {
+				sendBlank();
+			}
+		}
+		else {
+			sendLayers();
+		}
+
+		// define os parâmetros de filtragem (no atlas a repetição é feita no shader, dentro de cada imagem)
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, _isAtlas ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, _isAtlas ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+		// no atlas e na imagem branca, os dados já foram copiados para a textura (glTexSubImage3D copia antes de
+		// retornar); no array, só depois de o envio pelo anel terminar (finishUpload)
+		if (_isAtlas) {
+			for (Texture* texture : _textures) {
+				releaseTextureData(texture);
+			}
+		}
+
+		// envia a posição de cada imagem para o SSBO lido pelo fragment shader
+		glGenBuffers(1, &_slotBuffer);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, _slotBuffer);
+		glBufferStorage(GL_SHADER_STORAGE_BUFFER, _slots.size() * sizeof(TextureSlot), _slots.data(), 0);
+
+		_gpuBytes += (long long)(_slots.size() * sizeof(TextureSlot));
+		trackGpuMemory(MEMORY_TEXTURES, _gpuBytes);
+
+		return isSent;
+	}
+
+	void TextureArray::Poll(void) {
+		// se não há camadas a enviar
+		if (!isUploading()) {
+			return;
+		}
+
+		glActiveTexture(GL_TEXTURE0 + BALL_TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, _texture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		// emite as cópias dos lotes cujos dados já foram escritos pelas threads, pela ordem em que foram reservados
+		// (os que ainda estão a ser escritos ficam para a próxima frame)
+		while (!_uploadBatches.empty() && _uploadBatches.front()->copies.isDone()) {
+			UploadBatch* batch = _uploadBatches.front();
+			_uploadBatches.pop_front();
+
+			// a thread do OpenGL só emite as cópias do buffer para a textura, feitas pela GPU
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _uploadRing.getBuffer());
+			for (size_t i = 0; i < batch->levels.size(); i++) {
+				uploadLevel(batch->levels[i].first, batch->levels[i].second, (const void*)batch->offsets[i]);
+			}
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+			// as regiões deste lote só podem ser reescritas depois de a GPU as copiar
+			_uploadRing.fence(batch->segment, (int)batch->levels.size());
+			delete batch;
+		}
+
+		// reserva os níveis seguintes nos segmentos que ficaram livres
+		reserveLevels();
+	}
+
+	void TextureArray::Bind(void) {
+		// uma só textura e um só buffer para todas as bolas
+		glActiveTexture(GL_TEXTURE0 + BALL_TEXTURE_UNIT);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, _texture);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1 /*binding de TextureSlots*/, _slotBuffer);
+	}
+
+#pragma endregion
+
+
+#pragma region funções secundárias da classe TextureArray
+
+	void TextureArray::sendLayers(void) {
+		int width = _textures[0]->width;
+		int height = _textures[0]->height;
+		int numberOfLayers = (int)_textures.size();
+
+		// reserva todas as camadas e níveis de mipmap de uma só vez, no formato em que as imagens foram cozidas
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, _textures[0]->numberOfLevels, _textures[0]->format, width, height, numberOfLayers);
+		for (int level = 0; level < _textures[0]->numberOfLevels; level++) {
+			_gpuBytes += (long long)_textures[0]->levelSizes[level] * numberOfLayers;
+		}
+
+		// cada imagem ocupa a sua camada
+		_slots.clear();
+		std::vector<int> layers(numberOfLayers);
+		for (int i = 0; i < numberOfLayers; i++) {
+			layers[i] = i;
+			_slots.push_back({ glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), glm::ivec4(i, 0, 0, 0) });
+		}
+
+		// começa a enviar as imagens pelo anel de envio (o resto do envio é feito nas frames seguintes, em Poll)
+		startUpload(layers);
+	}
+
+	void TextureArray::startUpload(const std::vector<int>& layers) {
+		// cada nível de mipmap de cada camada é uma cópia (camada e nível)
+		_uploadLevels.clear();
+		_nextUploadLevel = 0;
+		size_t totalSize = 0;
+		size_t largestSize = 0;
+		for (int layer : layers) {
+			for (int level = 0; level < _textures[layer]->numberOfLevels; level++) {
+				size_t size = _textures[layer]->levelSizes[level];
+				_uploadLevels.push_back(std::make_pair(layer, level));
+				totalSize += (size + UPLOAD_RING_ALIGNMENT - 1) & ~(size_t)(UPLOAD_RING_ALIGNMENT - 1);
+				largestSize = std::max(largestSize, size);
+			}
+		}
+
+		// o anel é dimensionado para estas imagens (repartidas pelos segmentos, com espaço para o maior nível),
+		// até ao limite de um segmento; os níveis maiores do que o limite seguem da memória do cliente
+		size_t segmentSize = std::max(largestSize, (totalSize + UPLOAD_RING_SEGMENTS - 1) / UPLOAD_RING_SEGMENTS);
+		_uploadRing.create(std::min(segmentSize, (size_t)UPLOAD_RING_MAX_SEGMENT_SIZE), UPLOAD_RING_SEGMENTS);
+
+		reserveLevels();
+	}
+
+	void TextureArray::reserveLevels(void) {
+		UploadBatch* batch = nullptr;
+
+		while (_nextUploadLevel < _uploadLevels.size()) {
+			int layer = _uploadLevels[_nextUploadLevel].first;
+			int level = _uploadLevels[_nextUploadLevel].second;
+			const unsigned char* source = _textures[layer]->levels[level];
+			size_t size = _textures[layer]->levelSizes[level];
+
+			// se o nível não cabe num segmento (ou não há anel), é enviado diretamente da memória do cliente
+			if (!_uploadRing.isValid() || size > _uploadRing.getSegmentSize()) {
+				uploadLevel(layer, level, source);
+				_nextUploadLevel++;
+				continue;
+			}
+
+			// se o anel não tem espaço livre, os níveis seguintes ficam para a próxima frame
+			size_t offset;
+			if (!_uploadRing.allocate(size, &offset)) {
+				break;
+			}
+
+			// cada lote fica num só segmento, para ter a fence desse segmento
+			int segment = _uploadRing.getSegment(offset);
+			if (!batch || batch->segment != segment) {
+				batch = new UploadBatch;
+				batch->segment = segment;
+				_uploadBatches.push_back(batch);
+			}
+
+			// os dados são copiados para a memória mapeada por uma thread do sistema de tarefas
+			// (ou pela própria thread do OpenGL, se o sistema não tem workers e ninguém executaria a cópia)
+			unsigned char* target = _uploadRing.getData() + offset;
+			if (getJobSystem().getNumberOfWorkers() > 1) {
+				getJobSystem().submit(batch->copies, [source, target, size]() {
+					std::memcpy(target, source, size);
+				});
+			}
+			else {
+				std::memcpy(target, source, size);
+			}
+			batch->levels.push_back(_uploadLevels[_nextUploadLevel]);
+			batch->offsets.push_back(offset);
+			_nextUploadLevel++;
+		}
+
+		// se todos os níveis já foram reservados e emitidos
+		if (_nextUploadLevel == _uploadLevels.size() && _uploadBatches.empty()) {
+			finishUpload();
+		}
+	}
+
+	void TextureArray::finishUpload(void) {
+		// as cópias de todos os níveis já foram emitidas, por isso os dados deixam de ser precisos na CPU
+		for (Texture* texture : _textures) {
+			releaseTextureData(texture);
+		}
+
+		_uploadLevels.clear();
+		_nextUploadLevel = 0;
+
+		// o anel só ocupa memória enquanto há camadas a enviar (é criado outra vez no próximo envio);
+		// as cópias já emitidas não são afetadas, porque o OpenGL só apaga o buffer depois de a GPU o ler
+		_uploadRing.destroy();
+	}
+
+	void TextureArray::uploadLevel(int layer, int level, const void* pixels) {
+		// pixels é um endereço na memória do cliente ou, com o anel ligado, a posição dos dados no buffer
+		const Texture* texture = _textures[layer];
+		int width = std::max(1, texture->width >> level);
+		int height = std::max(1, texture->height >> level);
+
+		if (texture->format == GL_RGBA8) {
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+		}
+		else {
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, texture->format, (GLsizei)texture->levelSizes[level], pixels);
+		}
+	}
+
+	void TextureArray::sendBlank(void) {
+		const unsigned char white[4] = { 255, 255, 255, 255 };
+
+		// uma camada de 1x1 píxeis, usada por todas as imagens
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, 1, 1, 1);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, 1, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, white);
+		_gpuBytes += (long long)getLevelSize(GL_RGBA8, 1, 1);
+
+		TextureSlot slot;
+		slot.rect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+		slot.layer = glm::ivec4(0, 0, 0, 0);
+		_slots.assign(_textures.size(), slot);
+	}
+
+	bool TextureArray::sendAtlas(void) {
+		int numberOfTextures = (int)_textures.size();
+
+		// arruma primeiro as imagens mais altas, para as prateleiras ficarem mais cheias
+		std::vector<int> order(numberOfTextures);
+		for (int i = 0; i < numberOfTextures; i++) {
+			order[i] = i;
+		}
+		std::sort(order.begin(), order.end(), [this](int a, int b) {
+			return _textures[a]->height > _textures[b]->height;
+		});
+
+		// largura do atlas: potência de 2 que leva a imagem mais larga e se aproxima de um quadrado
+		long long area = 0;
+		int maxWidth = 0;
+		for (Texture* texture : _textures) {
+			area += (long long)(texture->width + 2 * ATLAS_PADDING) * (texture->height + 2 * ATLAS_PADDING);
+			maxWidth = std::max(maxWidth, texture->width + 2 * ATLAS_PADDING);
+		}
+
+		// se alguma imagem (com a margem) é maior do que o hardware suporta, não há como a arrumar
+		GLint maxSize;
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+		if (maxWidth > maxSize || _textures[order[0]]->height + 2 * ATLAS_PADDING > maxSize) {
+			std::cerr << "Imagem demasiado grande para o atlas de texturas (maximo " << maxSize << "x" << maxSize << ")." << std::endl;
+			return false;
+		}
+
+		int atlasWidth = 1;
+		while (atlasWidth < maxWidth || (long long)atlasWidth * atlasWidth < area) {
+			atlasWidth *= 2;
+		}
+		atlasWidth = std::min(atlasWidth, (int)maxSize);
+
+		// posição de cada imagem (em píxeis e camada), prateleira a prateleira; quando a camada fica mais
+		// alta do que o hardware suporta, as prateleiras seguintes passam para uma nova camada do array
+		std::vector<glm::ivec3> positions(numberOfTextures);
+		int x = 0, y = 0, shelfHeight = 0, layer = 0, atlasHeight = 0;
+
+		for (int index : order) {
+			int width = _textures[index]->width + 2 * ATLAS_PADDING;
+			int height = _textures[index]->height + 2 * ATLAS_PADDING;
+
+			// se a imagem já não cabe na prateleira atual, começa outra por baixo
+			if (x + width > atlasWidth) {
+				x = 0;
+				y += shelfHeight;
+				shelfHeight = 0;
+			}
+
+			// se a prateleira já não cabe na camada atual, começa outra camada
+			if (y + height > maxSize) {
+				x = 0;
+				y = 0;
+				shelfHeight = 0;
+				layer++;
+			}
+
+			positions[index] = glm::ivec3(x + ATLAS_PADDING, y + ATLAS_PADDING, layer);
+			x += width;
+			shelfHeight = std::max(shelfHeight, height);
+			atlasHeight = std::max(atlasHeight, y + shelfHeight);
+		}
+
+		int numberOfLayers = layer + 1;
+
+		// copia as imagens para o atlas (RGBA), estendendo a borda de cada uma pela margem
+		std::vector<unsigned char> atlas((size_t)atlasWidth * atlasHeight * 4 * numberOfLayers, 0);
+		std::vector<unsigned char> decompressed;
+		_slots.assign(numberOfTextures, TextureSlot());
+
+		for (int i = 0; i < numberOfTextures; i++) {
+			Texture* texture = _textures[i];
+			const unsigned char* image = texture->image;
+			int channels = texture->nChannels;
+
+			// as imagens comprimidas são descomprimidas (o atlas tem bordas que não coincidem com os blocos de 4x4)
+			if (!image) {
+				decompressed.resize((size_t)texture->width * texture->height * 4);
+				decompressBc1(texture->levels[0], texture->width, texture->height, decompressed.data());
+				image = decompressed.data();
+				channels = 4;
+			}
+
+			for (int row = -ATLAS_PADDING; row < texture->height + ATLAS_PADDING; row++) {
+				int sourceRow = std::min(std::max(row, 0), texture->height - 1);
+
+				for (int column = -ATLAS_PADDING; column < texture->width + ATLAS_PADDING; column++) {
+					int sourceColumn = std::min(std::max(column, 0), texture->width - 1);
+					const unsigned char* source = image + ((size_t)sourceRow * texture->width + sourceColumn) * channels;
+					unsigned char* target = &atlas[(((size_t)positions[i].z * atlasHeight + positions[i].y + row) * atlasWidth + positions[i].x + column) * 4];
+
+					target[0] = source[0];
+					target[1] = channels > 1 ? source[1] : source[0];
+					target[2] = channels > 2 ? source[2] : source[0];
+					target[3] = channels > 3 ? source[3] : 255;
+				}
+			}
+
+			_slots[i].rect = glm::vec4(
+				(float)positions[i].x / atlasWidth,
+				(float)positions[i].y / atlasHeight,
+				(float)texture->width / atlasWidth,
+				(float)texture->height / atlasHeight);
+			_slots[i].layer = glm::ivec4(positions[i].z, 0, 0, 0);
+		}
+
+		// o atlas é um array (normalmente com uma só camada), para o shader ser o mesmo nos dois modos
+		glTexStorage3D(GL_TEXTURE_2D_ARRAY, ATLAS_MIPMAP_LEVELS, GL_RGBA8, atlasWidth, atlasHeight, numberOfLayers);
+		for (int level = 0; level < ATLAS_MIPMAP_LEVELS; level++) {
+			_gpuBytes += (long long)getLevelSize(GL_RGBA8, std::max(1, atlasWidth >> level), std::max(1, atlasHeight >> level)) * numberOfLayers;
+		}
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, atlasWidth, atlasHeight, numberOfLayers, GL_RGBA, GL_UNSIGNED_BYTE, atlas.data());
+
+		// os níveis cozidos de cada imagem não servem para o atlas, por isso os seus mipmaps são gerados pela GPU
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+		return true;
+	}
+
+#pragma endregion
+
+}
@@ -0,0 +1,171 @@
+/*
+ * @descrição	Ficheiro com todas as assinaturas relativas ao agrupamento das texturas numa única textura.
+ * @ficheiro	Textures.h
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+*/
+
+
+#pragma once
+
+#ifndef TEXTURES_H
+#define TEXTURES_H 1
+
+#pragma region importações
+
+#include <vector>
+#include <deque>
+
+#define GLEW_STATIC
+#include <GL\glew.h>
+
+#include <glm\glm.hpp>
+
+#include "Jobs.h"
+#include "MappedFile.h"
+
+#pragma endregion
+
+
+#pragma region constantes
+
+#define BALL_TEXTURE_UNIT 0			// unidade de textura onde fica a textura de todas as bolas
+#define ATLAS_PADDING 4				// píxeis livres à volta de cada imagem no atlas (evita misturas entre imagens)
+#define ATLAS_MIPMAP_LEVELS 3		// níveis de mipmap do atlas (log2(ATLAS_PADDING) + 1, para as misturas não passarem a margem)
+#define TEXTURE_MAX_LEVELS 16		// níveis de mipmap que cabem numa textura (imagens até 32768 píxeis de lado)
+#define UPLOAD_RING_MAX_SEGMENT_SIZE (16 * 1024 * 1024)	// bytes máximos de cada segmento do anel de envio de texturas
+#define UPLOAD_RING_SEGMENTS 3						// segmentos do anel (um pode ser escrito enquanto os outros são lidos pela GPU)
+#define UPLOAD_RING_ALIGNMENT 16					// alinhamento de cada região reservada no anel
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region declarações das texturas
+
+	// estrutura para armazenados dados das texturas (já cozidas: todos os níveis de mipmap no formato da GPU)
+	typedef struct {
+		int width;				// largura da textura
+		int height;				// altura da textura
+		int nChannels;			// número de canais de cores de image
+		const unsigned char* image;	// imagem da textura em RGBA (nulo se está comprimida ou já foi enviada)
+		GLenum format;			// formato interno: GL_RGBA8 ou GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+		int numberOfLevels;		// níveis de mipmap guardados em levels
+		const unsigned char* levels[TEXTURE_MAX_LEVELS];	// dados de cada nível, prontos a enviar (nulos depois do envio)
+		size_t levelSizes[TEXTURE_MAX_LEVELS];				// bytes de cada nível
+		MappedFile* bakedFile;					// ficheiro cozido mapeado, onde estão os níveis (nulo se foram cozidos agora)
+		std::vector<unsigned char>* bakedData;	// níveis cozidos neste arranque (nulo se vieram do ficheiro)
+	} Texture;
+
+	// estrutura da posição de uma imagem dentro da textura agrupada (std430, igual a TextureSlot no fragment shader)
+	typedef struct {
+		glm::vec4 rect;			// xy: canto da imagem, zw: tamanho da imagem (em coordenadas de textura)
+		glm::ivec4 layer;		// x: camada da textura
+	} TextureSlot;
+
+	// classe de um anel de envio de píxeis: um pixel unpack buffer mapeado de forma persistente, dividido em
+	// segmentos, onde as threads do sistema de tarefas escrevem as imagens e de onde a GPU as copia para as texturas;
+	// cada segmento tem uma fence, para só ser reescrito depois de a GPU acabar de o ler;
+	// o buffer só existe entre create e destroy, chamados por quem envia as imagens
+	class UploadRing {
+	private:
+		// atributos privados
+		GLuint _buffer;
+		unsigned char* _data;			// memória do buffer, mapeada enquanto o anel existir
+		size_t _segmentSize;
+		int _numberOfSegments;
+		int _segment;					// segmento onde são feitas as reservas atuais
+		size_t _offset;					// primeira posição livre no segmento atual
+		std::vector<GLsync> _fences;	// fence da última cópia lida de cada segmento
+		std::vector<int> _pendingRegions;	// regiões reservadas em cada segmento cujas cópias ainda não foram emitidas
+		long long _numberOfWaits;		// vezes que a GPU ainda lia o segmento seguinte e a reserva foi adiada (somadas entre criações)
+		long long _uploadedBytes;		// bytes enviados pelo anel (somados entre criações)
+
+		// secundárias
+		bool isSegmentFree(int segment);
+
+	public:
+		// getters - obter valores de atributos fora da classe
+		GLuint getBuffer() const;
+		size_t getSegmentSize() const;
+		int getSegment(size_t offset) const;
+		unsigned char* getData() const;
+		bool isValid() const;
+		long long getNumberOfWaits() const;
+		long long getUploadedBytes() const;
+
+		// construtor
+		UploadRing();
+
+		// destrutor
+		~UploadRing();
+
+		// principais
+		bool create(size_t segmentSize, int numberOfSegments);
+		void destroy(void);
+		bool allocate(size_t size, size_t* offset);
+		void fence(int segment, int numberOfRegions);
+	};
+
+	// estrutura de um lote de níveis de mipmap escritos no mesmo segmento do anel de envio
+	typedef struct {
+		TaskGroup copies;							// cópias para a memória mapeada, feitas pelo sistema de tarefas
+		int segment;								// segmento do anel onde estão os dados
+		std::vector<std::pair<int, int>> levels;	// camada e nível de cada cópia
+		std::vector<size_t> offsets;				// posição dos dados de cada nível no anel
+	} UploadBatch;
+
+	// classe que junta várias texturas numa só, para serem todas usadas sem trocar de textura:
+	// um GL_TEXTURE_2D_ARRAY com uma camada por imagem quando têm todas o mesmo tamanho,
+	// ou um atlas (imagens lado a lado, numa camada ou mais se não couberem) quando os tamanhos são diferentes
+	class TextureArray {
+	private:
+		// atributos privados
+		std::vector<Texture*> _textures;
+		std::vector<TextureSlot> _slots;
+		GLuint _texture;
+		GLuint _slotBuffer;		// SSBO com a posição de cada imagem
+		bool _isAtlas;
+		long long _gpuBytes;	// memória da textura e do SSBO na GPU
+		UploadRing _uploadRing;	// anel de envio das camadas, criado com o tamanho das imagens a enviar
+		std::vector<std::pair<int, int>> _uploadLevels;	// camada e nível de cada cópia do envio em curso
+		size_t _nextUploadLevel;						// primeiro nível ainda por reservar no anel
+		std::deque<UploadBatch*> _uploadBatches;		// lotes reservados cujas cópias ainda não foram emitidas
+
+		// secundárias
+		void sendLayers(void);
+		bool sendAtlas(void);
+		void sendBlank(void);
+		void startUpload(const std::vector<int>& layers);
+		void reserveLevels(void);
+		void finishUpload(void);
+		void uploadLevel(int layer, int level, const void* pixels);
+
+	public:
+		// getters - obter valores de atributos fora da classe
+		int getNumberOfTextures() const;
+		const TextureSlot& getSlot(int index) const;
+		bool isAtlas() const;
+		bool isUploading() const;
+		long long getUploadedBytes() const;
+		long long getNumberOfUploadWaits() const;
+
+		// construtor
+		TextureArray();
+
+		// destrutor
+		~TextureArray();
+
+		// principais
+		int add(Texture* texture);
+		bool Send(void);
+		void Poll(void);
+		void Bind(void);
+	};
+
+#pragma endregion
+
+}
+
+#endif
@@ -0,0 +1,151 @@
+﻿/*
+ * @descrição	Ficheiro com todo o código relativo aos buffers de uniforms (câmara, luzes e materiais).
+ * @ficheiro	UniformBuffers.cpp
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+ *
+ * -------------------------------------
+ *
+ * Os dados comuns a todos os objetos (câmara e luzes) ficam em uniform blocks std140 e os materiais das
+ * bolas num SSBO indexado por instância. Cada buffer é escrito com uma única chamada, e só se o conteúdo
+ * mudou desde a última escrita; os shaders leem-nos pelos pontos de ligação fixos (UniformBuffers.h).
+*/
+
+
+#pragma region importações
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#define GLEW_STATIC
+#include <GL\glew.h>
+
+#define GLFW_USE_DWM_SWAP_INTERVAL
+#include <GLFW\glfw3.h>
+
+#include <glm\glm.hpp>
+
+#include "Memory.h"
+#include "UniformBuffers.h"
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region funções getters da classe UniformBuffer
+
+	GLuint UniformBuffer::getBuffer() const {
+		return _buffer;
+	}
+
+	int UniformBuffer::getNumberOfUpdates() const {
+		return _numberOfUpdates;
+	}
+
+#pragma endregion
+
+
+#pragma region construtor e destrutor da classe UniformBuffer
+
+	UniformBuffer::UniformBuffer() {
+		_buffer = 0;
+		_target = GL_UNIFORM_BUFFER;
+		_binding = 0;
+		_numberOfUpdates = 0;
+	}
+
+	UniformBuffer::~UniformBuffer() {
+		// o buffer só pode ser apagado enquanto existir um contexto OpenGL
+		if (_buffer && glfwGetCurrentContext()) {
+			trackGpuMemory(MEMORY_BUFFERS, -(long long)_data.size());
+			glDeleteBuffers(1, &_buffer);
+		}
+
+		trackCpuMemory(MEMORY_BUFFERS, -(long long)_data.size());
+	}
+
+#pragma endregion
+
+
+#pragma region funções principais da classe UniformBuffer
+
+	void UniformBuffer::create(GLenum target, GLuint binding, size_t size) {
+		_target = target;
+		_binding = binding;
+		_data.assign(size, 0);
+
+		// buffer imutável no tamanho, mas com o conteúdo atualizável
+		glGenBuffers(1, &_buffer);
+		glBindBuffer(_target, _buffer);
+		glBufferStorage(_target, size, _data.data(), GL_DYNAMIC_STORAGE_BIT);
+
+		// a cópia na CPU serve para ignorar as escritas que não mudam nada
+		trackCpuMemory(MEMORY_BUFFERS, (long long)size);
+		trackGpuMemory(MEMORY_BUFFERS, (long long)size);
+
+		Bind();
+	}
+
+	void UniformBuffer::update(const void* data, size_t size) {
+		// se nada mudou desde a última escrita, o buffer não é tocado
+		size = std::min(size, _data.size());
+		if (std::memcmp(_data.data(), data, size) == 0) {
+			return;
+		}
+
+		std::memcpy(_data.data(), data, size);
+
+		// todo o bloco é enviado numa só chamada
+		glBindBuffer(_target, _buffer);
+		glBufferSubData(_target, 0, size, data);
+		_numberOfUpdates++;
+	}
+
+	void UniformBuffer::Bind(void) {
+		glBindBufferBase(_target, _binding, _buffer);
+	}
+
+#pragma endregion
+
+
+#pragma region funções da classe MaterialArray
+
+	int MaterialArray::getNumberOfMaterials() const {
+		return (int)_materials.size();
+	}
+
+	int MaterialArray::add(float ns, glm::vec3 ka, glm::vec3 kd, glm::vec3 ks) {
+		MaterialData material = { glm::vec4(ka, ns), glm::vec4(kd, 0.0f), glm::vec4(ks, 0.0f) };
+
+		// bolas com o mesmo material partilham a mesma entrada
+		for (int i = 0; i < (int)_materials.size(); i++) {
+			if (std::memcmp(&_materials[i], &material, sizeof(MaterialData)) == 0) {
+				return i;
+			}
+		}
+
+		_materials.push_back(material);
+
+		return (int)_materials.size() - 1;
+	}
+
+	void MaterialArray::Send(void) {
+		// se não há materiais para enviar
+		if (_materials.empty()) {
+			return;
+		}
+
+		size_t size = _materials.size() * sizeof(MaterialData);
+		_buffer.create(GL_SHADER_STORAGE_BUFFER, MATERIALS_STORAGE_BINDING, size);
+		_buffer.update(_materials.data(), size);
+	}
+
+	void MaterialArray::Bind(void) {
+		_buffer.Bind();
+	}
+
+#pragma endregion
+
+}
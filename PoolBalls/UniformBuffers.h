@@ -0,0 +1,155 @@
+/*
+ * @descrição	Ficheiro com todas as assinaturas relativas aos buffers de uniforms (câmara, luzes e materiais).
+ * @ficheiro	UniformBuffers.h
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+*/
+
+
+#pragma once
+
+#ifndef UNIFORM_BUFFERS_H
+#define UNIFORM_BUFFERS_H 1
+
+#pragma region importações
+
+#include <vector>
+
+#define GLEW_STATIC
+#include <GL\glew.h>
+
+#include <glm\glm.hpp>
+
+#pragma endregion
+
+
+#pragma region constantes
+
+#define FRAME_UNIFORM_BINDING 0			// binding do bloco FrameData (uniform block)
+#define LIGHTS_UNIFORM_BINDING 1		// binding do bloco Lights (uniform block)
+#define MATERIALS_STORAGE_BINDING 2		// binding do bloco Materials (SSBO; 0 e 1 são as instâncias e as texturas)
+
+#pragma endregion
+
+
+namespace Pool {
+
+#pragma region declarações dos buffers de uniforms
+
+	// estrutura dos dados da câmara, atualizados uma vez por frame (std140, igual a FrameData nos shaders)
+	typedef struct {
+		glm::mat4 view;				// matriz de visualização
+		glm::mat4 projection;		// matriz de projeção
+		glm::vec4 viewPosition;		// xyz: posição da câmara
+		glm::ivec4 lighting;		// x: número de luzes da lista, y: tiles na horizontal, zw: tamanho do ecrã (Lights.h)
+	} FrameData;
+
+	// estruturas das fontes de luz (std140: cada vec3 é seguido de um float, para ocupar 16 bytes)
+	typedef struct {
+		glm::vec3 ambient;			// componente de luz ambiente
+		float padding;
+	} AmbientLightData;
+
+	typedef struct {
+		glm::vec3 direction;		// direção da luz
+		float padding0;
+		glm::vec3 ambient;			// componente de luz ambiente
+		float padding1;
+		glm::vec3 diffuse;			// componente de luz difusa
+		float padding2;
+		glm::vec3 specular;			// componente de luz especular
+		float padding3;
+	} DirectionalLightData;
+
+	typedef struct {
+		glm::vec3 position;			// posição do ponto de luz
+		float constant;				// atenuação constante
+		glm::vec3 ambient;			// componente de luz ambiente
+		float linear;				// atenuação linear
+		glm::vec3 diffuse;			// componente de luz difusa
+		float quadratic;			// atenuação quadrática
+		glm::vec3 specular;			// componente de luz especular
+		float padding;
+	} PointLightData;
+
+	typedef struct {
+		glm::vec3 position;			// posição do ponto de luz
+		float constant;				// atenuação constante
+		glm::vec3 direction;		// direção da luz
+		float linear;				// atenuação linear
+		glm::vec3 ambient;			// componente de luz ambiente
+		float quadratic;			// atenuação quadrática
+		glm::vec3 diffuse;			// componente de luz difusa
+		float cutOff;				// cosseno do ângulo interior
+		glm::vec3 specular;			// componente de luz especular
+		float outerCutOff;			// cosseno do ângulo exterior
+	} SpotLightData;
+
+	// estrutura de todas as luzes da cena, enviadas só quando mudam (std140, igual a Lights no fragment shader)
+	typedef struct {
+		AmbientLightData ambientLight;
+		DirectionalLightData directionalLight;
+		PointLightData pointLight;
+		SpotLightData spotLight;
+	} LightsData;
+
+	// estrutura de um material no buffer de materiais (std430, igual a MaterialData no fragment shader)
+	typedef struct {
+		glm::vec4 ambient;			// xyz: coeficiente de reflexão da luz ambiente, w: expoente especular
+		glm::vec4 diffuse;			// xyz: coeficiente de reflexão da luz difusa
+		glm::vec4 specular;			// xyz: coeficiente de reflexão da luz especular
+	} MaterialData;
+
+	static_assert(sizeof(FrameData) == 160, "FrameData não segue a disposição std140");
+	static_assert(sizeof(LightsData) == 224, "LightsData não segue a disposição std140");
+	static_assert(sizeof(MaterialData) == 48, "MaterialData não segue a disposição std430");
+
+	// classe de um buffer ligado a um ponto de ligação fixo (uniform block ou SSBO), escrito de uma só vez
+	class UniformBuffer {
+	private:
+		// atributos privados
+		GLuint _buffer;
+		GLenum _target;						// GL_UNIFORM_BUFFER ou GL_SHADER_STORAGE_BUFFER
+		GLuint _binding;
+		std::vector<unsigned char> _data;	// cópia do último conteúdo enviado
+		int _numberOfUpdates;				// escritas feitas no buffer (as que não mudavam nada são ignoradas)
+
+	public:
+		// getters - obter valores de atributos fora da classe
+		GLuint getBuffer() const;
+		int getNumberOfUpdates() const;
+
+		// construtor
+		UniformBuffer();
+
+		// destrutor
+		~UniformBuffer();
+
+		// principais
+		void create(GLenum target, GLuint binding, size_t size);
+		void update(const void* data, size_t size);
+		void Bind(void);
+	};
+
+	// classe que junta os materiais de todas as bolas num único buffer, indexado por instância
+	class MaterialArray {
+	private:
+		// atributos privados
+		std::vector<MaterialData> _materials;
+		UniformBuffer _buffer;
+
+	public:
+		// getters - obter valores de atributos fora da classe
+		int getNumberOfMaterials() const;
+
+		// principais
+		int add(float ns, glm::vec3 ka, glm::vec3 kd, glm::vec3 ks);
+		void Send(void);
+		void Bind(void);
+	};
+
+#pragma endregion
+
+}
+
+#endif
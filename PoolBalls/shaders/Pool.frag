@@ -8,14 +8,29 @@
 
 #version 440 core
 
+// variante do programa, definida em Pool::getProgramVariant (valores por omissão se o shader for compilado sem #define)
+#ifndef LIGHT_MODEL
+#define LIGHT_MODEL 1		// 1 ambiente, 2 direcional, 3 pontual, 4 cónica, 5 lista de luzes
+#endif
+#ifndef TEXTURED
+#define TEXTURED 0			// 1 se o objeto tem textura (bolas)
+#endif
+#ifndef INSTANCED
+#define INSTANCED 0			// 1 se o objeto é desenhado por instância, com os dados no buffer de instâncias (bolas)
+#endif
+
 uniform mat4 Model;
-uniform mat4 View;
 uniform mat4 ModelView;
 uniform mat3 NormalMatrix;
-uniform int lightModel;
-uniform sampler2D sampler;
-uniform int isRenderTexture;
-uniform vec3 viewPosition;
+uniform sampler2DArray ballTextures;
+
+// dados da câmara, atualizados uma vez por frame (std140, igual a Pool::FrameData)
+layout(std140, binding = 0) uniform FrameData {
+	mat4 View;
+	mat4 Projection;
+	vec4 viewPosition;	// xyz: posição da câmara
+	ivec4 lighting;		// x: número de luzes, y: tiles na horizontal, zw: tamanho do ecrã
+};
 
 layout(location = 0) in vec3 color;
 layout(location = 1) in vec2 textureCoord;
@@ -25,48 +40,52 @@ layout(location = 2) in vec3 vPositionEyeSpace;
 layout(location = 3) in vec3 vNormalEyeSpace;
 layout(location = 4) in vec3 textureVector;
 layout(location = 5) in vec3 fPosition;
+layout(location = 6) flat in int instanceIndex;
+
+// estruturas das fontes de luz (std140, iguais às de Pool::LightsData: cada vec3 é seguido de um float)
 
 // estrutura da fonte de luz ambiente
 struct AmbientLight {
 	vec3 ambient;		// componente de luz ambiente
+	float padding;
 };
 
 // estrutura de uma fonte de luz direcional
 struct DirectionalLight	{
 	vec3 direction;		// direção da luz
-	
+	float padding0;
 	vec3 ambient;		// componente de luz ambiente
+	float padding1;
 	vec3 diffuse;		// componente de luz difusa
+	float padding2;
 	vec3 specular;		// componente de luz especular
+	float padding3;
 };
 
 // estrutura de uma fonte de luz pontual
 struct PointLight {
 	vec3 position;		// posição do ponto de luz
-	
-	vec3 ambient;		// componente de luz ambiente
-	vec3 diffuse;		// componente de luz difusa
-	vec3 specular;		// componente de luz especular
-	
 	float constant;		// atenuação constante
+	vec3 ambient;		// componente de luz ambiente
 	float linear;		// atenuação linear
+	vec3 diffuse;		// componente de luz difusa
 	float quadratic;	// atenuação quadrática
+	vec3 specular;		// componente de luz especular
+	float padding;
 };
 
 // estrutura de uma fonte de luz cónica
 struct SpotLight {
 	vec3 position;		// posição do ponto de luz
+	float constant;		// atenuação constante
 	vec3 direction;		// direção da luz, espaço do mundo
-
+	float linear;		// atenuação linear
 	vec3 ambient;		// componente de luz ambiente
+	float quadratic;	// atenuação quadrática
 	vec3 diffuse;		// componente de luz difusa
+	float cutOff;		// ângulo de abertura interior
 	vec3 specular;		// componente de luz especular
-	
-	float constant;		// atenuação constante
-	float linear;		// atenuação linear
-	float quadratic;	// atenuação quadrática
-
-	float cutOff, outerCutOff;	// ângulo de abertura
+	float outerCutOff;	// ângulo de abertura exterior
 };
 
 // estrutura do material do objeto
@@ -77,44 +96,133 @@ struct Material {
 	vec3 specular;		// ks
 };
 
-uniform AmbientLight ambientLight;			// fonte de luz ambiente
-uniform DirectionalLight directionalLight;	// fonte de luz direcional
-uniform PointLight pointLight;				// fonte de luz pontual
-uniform SpotLight spotLight;				// fonte de luz cónica
-uniform Material material;					// material do objeto
+// todas as luzes da cena, enviadas numa só escrita quando mudam
+layout(std140, binding = 1) uniform Lights {
+	AmbientLight ambientLight;			// fonte de luz ambiente
+	DirectionalLight directionalLight;	// fonte de luz direcional
+	PointLight pointLight;				// fonte de luz pontual
+	SpotLight spotLight;				// fonte de luz cónica
+};
+
+// estrutura dos dados de cada bola desenhada por instância (igual a Pool::BallInstance)
+struct BallInstance {
+	mat4 model;
+	mat4 modelView;
+	mat4 normalMatrix;
+	ivec4 indices;		// x: índice da imagem em TextureSlots (-1 sem textura), y: índice do material em Materials
+};
+
+layout(std430, binding = 0) readonly buffer BallInstances {
+	BallInstance instances[];
+};
+
+// estrutura da posição de uma imagem na textura das bolas (igual a Pool::TextureSlot)
+struct TextureSlot {
+	vec4 rect;			// xy: canto da imagem, zw: tamanho da imagem
+	ivec4 layer;		// x: camada do array
+};
+
+layout(std430, binding = 1) readonly buffer TextureSlots {
+	TextureSlot slots[];
+};
+
+// estrutura de um material no buffer de materiais (igual a Pool::MaterialData)
+struct MaterialData {
+	vec4 ambient;		// xyz: Ka, w: Ns
+	vec4 diffuse;		// xyz: Kd
+	vec4 specular;		// xyz: Ks
+};
+
+layout(std430, binding = 2) readonly buffer Materials {
+	MaterialData materials[];
+};
+
+#if LIGHT_MODEL == 5
+// constantes injetadas por Pool::getTiledLightingDefines (valores por omissão iguais aos de Lights.h)
+#ifndef LIGHT_TILE_SIZE
+#define LIGHT_TILE_SIZE 16
+#define MAX_LIGHTS_PER_TILE 64
+#define LIGHT_DIRECTIONAL 0
+#define LIGHT_POINT 1
+#define LIGHT_SPOT 2
+#endif
+
+// estrutura de uma luz da lista (igual a Pool::LightData)
+struct LightData {
+	vec4 position;		// xyz: posição, w: tipo
+	vec4 direction;		// xyz: direção, w: alcance (negativo se é infinito)
+	vec4 ambient;
+	vec4 diffuse;
+	vec4 specular;
+	vec4 attenuation;	// x: constante, y: linear, z: quadrática
+	vec4 cone;			// x: cosseno do ângulo interior, y: cosseno do ângulo exterior
+};
+
+layout(std430, binding = 3) readonly buffer LightList {
+	LightData lights[];
+};
+
+// luzes de cada tile do ecrã, escolhidas por LightCulling.comp (número de luzes seguido dos índices)
+layout(std430, binding = 4) readonly buffer TileLights {
+	uint tileLights[];
+};
+#endif
+
+uniform Material material;					// material do objeto (mesa)
+
+Material objectMaterial;					// material usado no fragmento atual (da mesa ou da instância)
 
 vec4 calcAmbientLight(AmbientLight light);
 vec4 calcDirectionalLight(DirectionalLight light);
 vec4 calcPointLight(PointLight light);
 vec4 calcSpotLight(SpotLight light);
 vec4 calcSpotLight2(SpotLight light);
+#if LIGHT_MODEL == 5
+vec4 calcLightList();
+vec3 calcListLight(LightData light, vec3 N, vec3 V);
+#endif
+
+vec4 sampleBallTexture(int slot, vec2 coord);
 
 void main() {
 	vec4 lightToUse;
 
-	// verifica qual a luz atual
-	if (lightModel == 2) {
-		lightToUse = calcDirectionalLight(directionalLight);
-	} else if (lightModel == 3) {
-		lightToUse = calcPointLight(pointLight);
-	} else if (lightModel == 4) {
-		lightToUse = calcSpotLight(spotLight);
-	} else {
-		lightToUse = calcAmbientLight(ambientLight);
-	}
-
+	// as bolas desenhadas por instância indicam o seu material no buffer de materiais
+	objectMaterial = material;
+#if INSTANCED
+	MaterialData instanceMaterial = materials[instances[instanceIndex].indices.y];
+	objectMaterial.shininess = instanceMaterial.ambient.w;
+	objectMaterial.ambient = instanceMaterial.ambient.xyz;
+	objectMaterial.diffuse = instanceMaterial.diffuse.xyz;
+	objectMaterial.specular = instanceMaterial.specular.xyz;
+#endif
+
+	// a luz é escolhida ao compilar a variante, e não em cada fragmento
+#if LIGHT_MODEL == 2
+	lightToUse = calcDirectionalLight(directionalLight);
+#elif LIGHT_MODEL == 3
+	lightToUse = calcPointLight(pointLight);
+#elif LIGHT_MODEL == 4
+	lightToUse = calcSpotLight(spotLight);
+#elif LIGHT_MODEL == 5
+	lightToUse = calcLightList();
+#else
+	lightToUse = calcAmbientLight(ambientLight);
+#endif
+
+#if TEXTURED
 	// se tem textura (bola)
-	if (isRenderTexture == 1) {
-		vec4 texColor = texture(sampler, textureCoord);
-		fColor = lightToUse * texColor;
-	} else {   // se não tem textura (mesa)
-		fColor = lightToUse * vec4(color, 1.0f);
-	}
+	vec4 texColor = sampleBallTexture(instances[instanceIndex].indices.x, textureCoord);
+	fColor = lightToUse * texColor;
+#else
+	// se não tem textura (mesa)
+	fColor = lightToUse * vec4(color, 1.0f);
+#endif
 }
 
 vec4 calcAmbientLight(AmbientLight light) {
 	// cálculo da contribuição da luz ambiente
-	vec4 ambient = vec4(material.ambient * light.ambient, 1.0);
+	vec4 ambient = vec4(objectMaterial.ambient * light.ambient, 1.0);
 
 	// retorna a fonte de luz ambiente
 	return ambient;
@@ -122,20 +230,20 @@ vec4 calcAmbientLight(AmbientLight light) {
 
 vec4 calcDirectionalLight(DirectionalLight light) {
 	// cálculo da contribuição da luz ambiente
-	vec4 ambient = vec4(material.ambient * light.ambient, 1.0);
+	vec4 ambient = vec4(objectMaterial.ambient * light.ambient, 1.0);
 
 	// cálculo da contribuição da luz difusa
 	vec3 lightDirectionEyeSpace = (View * vec4(light.direction, 0.0)).xyz;
 	vec3 L = normalize(-lightDirectionEyeSpace);
 	vec3 N = normalize(vNormalEyeSpace);
 	float NdotL = max(dot(N, L), 0.0);
-	vec4 diffuse = vec4(material.diffuse * light.diffuse, 1.0) * NdotL;
+	vec4 diffuse = vec4(objectMaterial.diffuse * light.diffuse, 1.0) * NdotL;
 
 	// cálculo da contribuição da luz especular
 	vec3 V = normalize(-vPositionEyeSpace);
 	vec3 R = reflect(-L, N);
 	float RdotV = max(dot(R, V), 0.0);
-	vec4 specular = pow(RdotV, material.shininess) * vec4(light.specular * material.specular, 1.0);
+	vec4 specular = pow(RdotV, objectMaterial.shininess) * vec4(light.specular * objectMaterial.specular, 1.0);
 
 	// retorna a fonte de luz direcional
 	return ambient + diffuse + specular;
@@ -143,20 +251,20 @@ vec4 calcDirectionalLight(DirectionalLight light) {
 
 vec4 calcPointLight(PointLight light) {
 	// cálculo da contribuição da luz ambiente
-	vec4 ambient = vec4(material.ambient * light.ambient, 1.0);
+	vec4 ambient = vec4(objectMaterial.ambient * light.ambient, 1.0);
 
 	// cálculo da contribuição da luz difusa
 	vec3 lightPositionEyeSpace = (View * vec4(light.position, 1.0)).xyz;
 	vec3 L = normalize(lightPositionEyeSpace - vPositionEyeSpace);
 	vec3 N = normalize(vNormalEyeSpace);
 	float NdotL = max(dot(N, L), 0.0);
-	vec4 diffuse = vec4(material.diffuse * light.diffuse, 1.0) * NdotL;
+	vec4 diffuse = vec4(objectMaterial.diffuse * light.diffuse, 1.0) * NdotL;
 
 	// cálculo da contribuição da luz especular
 	vec3 V = normalize(-vPositionEyeSpace);
 	vec3 R = reflect(-L, N);
 	float RdotV = max(dot(R, V), 0.0);
-	vec4 specular = pow(RdotV, material.shininess) * vec4(light.specular * material.specular, 1.0);
+	vec4 specular = pow(RdotV, objectMaterial.shininess) * vec4(light.specular * objectMaterial.specular, 1.0);
 	
 	// atenuação
 	float distance = length(mat3(View) * light.position - vPositionEyeSpace);	// cálculo da distância entre o ponto de luz e o vértice
@@ -168,7 +276,7 @@ vec4 calcPointLight(PointLight light) {
 
 vec4 calcSpotLight(SpotLight light) {
 	// cálculo da contribuição da luz ambiente
-    vec3 ambient =  material.ambient * light.ambient;
+    vec3 ambient =  objectMaterial.ambient * light.ambient;
 
 	// cálculo da contribuição da luz difusa
     vec3 norm = normalize(color);
@@ -178,9 +286,9 @@ vec4 calcSpotLight(SpotLight light) {
 	vec3 diffuse = light.diffuse * smoothDiffuse;
 
 	// cálculo da contribuição da luz especular
-	vec3 viewDir = normalize(viewPosition - fPosition);
+	vec3 viewDir = normalize(viewPosition.xyz - fPosition);
 	vec3 reflectDir = reflect(-lightDir, norm);
-	float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+	float spec = pow(max(dot(viewDir, reflectDir), 0.0), objectMaterial.shininess);
 	float smoothSpecular = smoothstep(light.outerCutOff, light.cutOff, diffuseIntensity);
 	vec3 specular = light.specular * spec * smoothSpecular;
 
@@ -193,4 +301,87 @@ vec4 calcSpotLight(SpotLight light) {
 
 	// retorna a fonte de luz cónica
     return vec4(ambient + diffuse + specular, 1.0f);
+}
+
+#if LIGHT_MODEL == 5
+vec4 calcLightList() {
+	// só as luzes que podem iluminar o tile do fragmento (o custo não cresce com o número de luzes da cena)
+	ivec2 tile = ivec2(gl_FragCoord.xy) / LIGHT_TILE_SIZE;
+	uint base = uint(tile.y * lighting.y + tile.x) * uint(MAX_LIGHTS_PER_TILE + 1);
+	uint count = tileLights[base];
+
+	vec3 N = normalize(vNormalEyeSpace);
+	vec3 V = normalize(-vPositionEyeSpace);
+	vec3 result = vec3(0.0);
+
+	for (uint i = 0u; i < count; i++) {
+		result += calcListLight(lights[tileLights[base + 1u + i]], N, V);
+	}
+
+	// retorna a soma de todas as luzes
+	return vec4(result, 1.0);
+}
+
+vec3 calcListLight(LightData light, vec3 N, vec3 V) {
+	int type = int(light.position.w);
+	vec3 L;
+	float attenuation = 1.0;
+	float spot = 1.0;
+
+	if (type == LIGHT_DIRECTIONAL) {
+		// direção da luz no espaço da câmara
+		L = normalize(-(View * vec4(light.direction.xyz, 0.0)).xyz);
+	} else {
+		// posição da luz no espaço da câmara
+		vec3 toLight = (View * vec4(light.position.xyz, 1.0)).xyz - vPositionEyeSpace;
+		float distance = length(toLight);
+		L = toLight / distance;
+
+		// atenuação, que chega a zero no alcance usado na seleção por tiles (para não se verem as arestas dos tiles)
+		attenuation = 1.0 / (light.attenuation.x + light.attenuation.y * distance + light.attenuation.z * (distance * distance));
+		float range = light.direction.w;
+		if (range >= 0.0) {
+			float ratio = distance / max(range, 0.0001);
+			float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+			attenuation *= window * window;
+		}
+
+		// abertura do cone da luz cónica
+		if (type == LIGHT_SPOT) {
+			vec3 spotDirection = normalize((View * vec4(light.direction.xyz, 0.0)).xyz);
+			spot = smoothstep(light.cone.y, light.cone.x, dot(-L, spotDirection));
+		}
+	}
+
+	// cálculo da contribuição da luz ambiente
+	vec3 ambient = objectMaterial.ambient * light.ambient.xyz;
+
+	// cálculo da contribuição da luz difusa
+	float NdotL = max(dot(N, L), 0.0);
+	vec3 diffuse = objectMaterial.diffuse * light.diffuse.xyz * NdotL;
+
+	// cálculo da contribuição da luz especular
+	vec3 R = reflect(-L, N);
+	float RdotV = max(dot(R, V), 0.0);
+	vec3 specular = objectMaterial.specular * light.specular.xyz * pow(RdotV, objectMaterial.shininess);
+
+	return attenuation * (ambient + spot * (diffuse + specular));
+}
+#endif
+
+vec4 sampleBallTexture(int slot, vec2 coord) {
+	// se a bola não tem textura
+	if (slot < 0) {
+		return vec4(1.0);
+	}
+
+	// as derivadas são calculadas com as coordenadas originais (contínuas), antes da repetição dentro da imagem
+	vec4 rect = slots[slot].rect;
+	vec2 dx = dFdx(coord) * rect.zw;
+	vec2 dy = dFdy(coord) * rect.zw;
+
+	// no atlas, a repetição tem de ficar dentro da região da imagem (num array, rect cobre a camada toda)
+	vec2 atlasCoord = rect.xy + fract(coord) * rect.zw;
+
+	return textureGrad(ballTextures, vec3(atlasCoord, slots[slot].layer.x), dx, dy);
 }
\ No newline at end of file
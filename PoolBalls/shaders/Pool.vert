@@ -1,13 +1,18 @@
 /*
- * @descrio	Ficheiro relativo ao vertex shader.
+ * @descrição	Ficheiro relativo ao vertex shader.
  * @ficheiro	Pool.vert
- * @autor(s)	Henrique Azevedo a23488, Lus Pereira a18446, Pedro Silva a20721, Vnia Pereira a19264
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
  * @data		11/06/2023
 */
 
 
 #version 440 core
 
+// variante do programa, definida em Pool::getProgramVariant (valor por omissão se o shader for compilado sem #define)
+#ifndef INSTANCED
+#define INSTANCED 0			// 1 se o objeto é desenhado por instância, com os dados no buffer de instâncias (bolas)
+#endif
+
 layout(location = 0) in vec3 vPosition;
 layout(location = 1) in vec3 vColor;
 layout(location = 2) in vec2 vTextureCoord;
@@ -19,30 +24,61 @@ layout(location = 2) out vec3 vPositionEyeSpace;
 layout(location = 3) out vec3 vNormalEyeSpace;
 layout(location = 4) out vec3 textureVector;
 layout(location = 5) out vec3 fPosition;
+layout(location = 6) flat out int instanceIndex;
+
+// estrutura dos dados de cada bola desenhada por instância (igual a Pool::BallInstance)
+struct BallInstance {
+	mat4 model;
+	mat4 modelView;
+	mat4 normalMatrix;
+	ivec4 indices;		// x: índice da imagem em TextureSlots, y: índice do material em Materials
+};
+
+layout(std430, binding = 0) readonly buffer BallInstances {
+	BallInstance instances[];
+};
+
+// dados da câmara, atualizados uma vez por frame (std140, igual a Pool::FrameData)
+layout(std140, binding = 0) uniform FrameData {
+	mat4 View;
+	mat4 Projection;
+	vec4 viewPosition;	// xyz: posição da câmara
+	ivec4 lighting;		// x: número de luzes, y: tiles na horizontal, zw: tamanho do ecrã
+};
 
 uniform mat4 Model;
-uniform mat4 View;
 uniform mat4 ModelView;
-uniform mat4 Projection;
 uniform mat3 NormalMatrix;
 
 void main()
 {
-    // posio do vrtice de entrada
-    gl_Position = Projection * ModelView * vec4(vPosition, 1.0);
+#if INSTANCED
+	// bola desenhada por instância: as matrizes vêm do buffer de instâncias
+	mat4 model = instances[gl_InstanceID].model;
+	mat4 modelView = instances[gl_InstanceID].modelView;
+	mat3 normalMatrix = mat3(instances[gl_InstanceID].normalMatrix);
+#else
+	mat4 model = Model;
+	mat4 modelView = ModelView;
+	mat3 normalMatrix = NormalMatrix;
+#endif
+	instanceIndex = gl_InstanceID;
+
+    // posição do vértice de entrada
+    gl_Position = Projection * modelView * vec4(vPosition, 1.0);
  
-    // cor do vrtice de entrada
+    // cor do vértice de entrada
     color = vColor;
 
-    // coordenadas de textura do vrtice
+    // coordenadas de textura do vértice
 	textureCoord = vTextureCoord;
 
-    // posio do vrtice em coordenadas de olho
-	vPositionEyeSpace = (ModelView * vec4(vPosition, 1.0)).xyz;
+    // posição do vértice em coordenadas de olho
+	vPositionEyeSpace = (modelView * vec4(vPosition, 1.0)).xyz;
 
-	// normaliza a normal do vrtice
-	vNormalEyeSpace = normalize(NormalMatrix * vColor);
+	// normaliza a normal do vértice
+	vNormalEyeSpace = normalize(normalMatrix * vColor);
 
-    // posio do vrtice de sada
-	fPosition = vec3(Model * vec4(vPosition, 1.0f));
+    // posição do vértice de saída
+	fPosition = vec3(model * vec4(vPosition, 1.0f));
 }
\ No newline at end of file
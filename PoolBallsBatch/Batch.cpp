@@ -0,0 +1,233 @@
+﻿/*
+ * @descrição	Ficheiro principal da simulação em lote, sem janela nem contexto OpenGL.
+ * @ficheiro	Batch.cpp
+ * @autor(s)	Henrique Azevedo a23488, Luís Pereira a18446, Pedro Silva a20721, Vânia Pereira a19264
+ * @data		11/06/2023
+ *
+ * -------------------------------------
+ *
+ * Lê um ficheiro de tacadas, simula cada uma a partir da disposição inicial da cena (a mesma da aplicação)
+ * usando todos os núcleos da máquina e escreve o estado final da mesa de cada tacada.
+ *
+ * Utilização: PoolBallsBatch <ficheiro de tacadas> <ficheiro de resultados> [número de threads]
+ *
+ * Cada linha do ficheiro de tacadas tem: <bola> <velocidade X> <velocidade Z> <duração> [f|e]
+ * (bola de 1 a 15, velocidades em unidades por segundo, duração em segundos, motor com passo fixo ou por eventos).
+ * As linhas vazias ou começadas por '#' são ignoradas.
+ *
+ * Cada linha do ficheiro de resultados tem o número da tacada seguido das posições X e Z finais de cada bola.
+*/
+
+
+#pragma region importações
+
+#include <iostream>
+#include <cstdlib>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+#include <glm\glm.hpp>
+
+#include "Physics.h"
+#include "EventPhysics.h"
+#include "Scene.h"
+#include "Narrowphase.h"
+#include "Jobs.h"
+
+#pragma endregion
+
+
+#pragma region constantes
+
+#define SHOTS_PER_BLOCK 65536		// tacadas lidas e simuladas de cada vez (limita a memória usada)
+#define SHOTS_PER_TASK 16			// tacadas por tarefa do sistema de tarefas
+
+#pragma endregion
+
+
+#pragma region estruturas
+
+// estrutura de uma tacada
+typedef struct {
+	int ball;				// índice da bola tacada
+	glm::vec3 velocity;		// velocidade inicial da bola
+	double duration;		// tempo simulado (segundos)
+	bool eventDriven;		// se usa a simulação por eventos
+} Shot;
+
+// estrutura com o estado final da mesa
+typedef struct {
+	float x[NUMBER_OF_BALLS];
+	float z[NUMBER_OF_BALLS];
+} TableState;
+
+#pragma endregion
+
+
+#pragma region funções
+
+int readShots(std::ifstream& file, int& lineNumber, std::vector<Shot>& shots) {
+	// reutiliza o mesmo buffer em todos os blocos (a capacidade reservada mantém-se)
+	shots.clear();
+
+	std::string line;
+	while (shots.size() < SHOTS_PER_BLOCK && std::getline(file, line)) {
+		lineNumber++;
+
+		// ignora linhas vazias ou comentadas
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+
+		std::istringstream stream(line);
+		Shot shot;
+		float vx, vz;
+		std::string engine = "f";
+
+		if (!(stream >> shot.ball >> vx >> vz >> shot.duration) || shot.ball < 1 || shot.ball > NUMBER_OF_BALLS) {
+			std::cerr << "Tacada invalida na linha " << lineNumber << "." << std::endl;
+			return -1;
+		}
+
+		// motor opcional: 'f' (passo fixo, por omissão) ou 'e' (por eventos), sem mais nada na linha
+		std::string extra;
+		if ((stream >> engine && engine != "f" && engine != "e") || stream >> extra) {
+			std::cerr << "Tacada invalida na linha " << lineNumber << "." << std::endl;
+			return -1;
+		}
+
+		shot.ball -= 1;
+		shot.velocity = glm::vec3(vx, 0.0f, vz);
+		shot.eventDriven = engine == "e";
+		shots.push_back(shot);
+	}
+
+	return (int)shots.size();
+}
+
+void simulateShot(const Shot& shot, TableState& state) {
+	Pool::Physics fixedStepPhysics;
+	Pool::EventPhysics eventPhysics;
+	Pool::Simulation* simulation = shot.eventDriven ? (Pool::Simulation*)&eventPhysics : (Pool::Simulation*)&fixedStepPhysics;
+
+	// parte sempre da disposição inicial da cena
+	Pool::loadScene(simulation);
+	simulation->setVelocity(shot.ball, shot.velocity);
+	simulation->simulate(shot.duration);
+
+	for (int i = 0; i < NUMBER_OF_BALLS; i++) {
+		glm::vec3 position = simulation->getPosition(i);
+		state.x[i] = position.x;
+		state.z[i] = position.z;
+	}
+}
+
+void simulateBlock(const std::vector<Shot>& shots, std::vector<TableState>& states) {
+	// as tacadas têm durações diferentes, por isso os workers que acabam primeiro roubam tarefas aos outros
+	Pool::getJobSystem().parallelFor(0, (int)shots.size(), SHOTS_PER_TASK, [&](int from, int to) {
+		for (int i = from; i < to; i++) {
+			simulateShot(shots[i], states[i]);
+		}
+	});
+}
+
+void writeBlock(std::ofstream& output, size_t first, int count, const std::vector<TableState>& states) {
+	for (int i = 0; i < count; i++) {
+		output << (first + i + 1);
+		for (int b = 0; b < NUMBER_OF_BALLS; b++) {
+			output << ' ' << states[i].x[b] << ' ' << states[i].z[b];
+		}
+		output << '\n';
+	}
+}
+
+#pragma endregion
+
+
+#pragma region ponto de entrada do programa
+
+int main(int argc, char** argv) {
+	// se não foram passados os ficheiros
+	if (argc < 3) {
+		std::cout << "Utilizacao: PoolBallsBatch <ficheiro de tacadas> <ficheiro de resultados> [numero de threads]" << std::endl;
+		return -1;
+	}
+
+	// usa todos os núcleos, a não ser que seja indicado outro número de threads
+	int numberOfThreads = argc > 3 ? std::atoi(argv[3]) : (int)std::thread::hardware_concurrency();
+	if (numberOfThreads < 1) {
+		numberOfThreads = 1;
+	}
+
+	// a thread principal também executa tarefas enquanto espera
+	Pool::startJobSystem(numberOfThreads - 1);
+
+	std::ifstream input(argv[1]);
+	if (!input) {
+		std::cerr << "Erro ao abrir o ficheiro '" << argv[1] << "'." << std::endl;
+		return -1;
+	}
+
+	std::ofstream output(argv[2]);
+	if (!output) {
+		std::cerr << "Erro ao criar o ficheiro '" << argv[2] << "'." << std::endl;
+		return -1;
+	}
+
+	std::cout << numberOfThreads << " threads, kernel " << Pool::getNarrowphaseKernelName() << "." << std::endl;
+	auto start = std::chrono::steady_clock::now();
+
+	// lê, simula e escreve as tacadas por blocos: só um bloco de tacadas fica em memória, e a escrita de um
+	// bloco (numa thread à parte) decorre enquanto o bloco seguinte é lido e simulado, com outro buffer de estados
+	std::vector<Shot> shots;
+	shots.reserve(SHOTS_PER_BLOCK);
+	std::vector<TableState> states[2] = { std::vector<TableState>(SHOTS_PER_BLOCK), std::vector<TableState>(SHOTS_PER_BLOCK) };
+	std::thread writer;
+	int current = 0;
+	int lineNumber = 0;
+	size_t numberOfShots = 0;
+	bool isValid = true;
+
+	while (true) {
+		int count = readShots(input, lineNumber, shots);
+		if (count <= 0) {
+			isValid = count == 0;
+			break;
+		}
+
+		simulateBlock(shots, states[current]);
+
+		// espera que o bloco anterior acabe de ser escrito antes de começar a escrever este
+		if (writer.joinable()) {
+			writer.join();
+		}
+		writer = std::thread(writeBlock, std::ref(output), numberOfShots, count, std::cref(states[current]));
+
+		numberOfShots += count;
+		current = 1 - current;
+	}
+
+	if (writer.joinable()) {
+		writer.join();
+	}
+
+	// se houve uma tacada inválida, os resultados ficam incompletos
+	if (!isValid) {
+		return -1;
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Concluido: " << numberOfShots << " tacadas em " << seconds << " s (" << numberOfShots / seconds << " tacadas por segundo)." << std::endl;
+
+	// distribuição das tarefas pelos workers
+	Pool::getJobSystem().printStats(std::cout);
+
+	return 0;
+}
+
+#pragma endregion